@@ -35,6 +35,8 @@
 #include <sdlgui/switchbox.h>
 #include <sdlgui/formhelper.h>
 #include <memory>
+#include <thread>
+#include <chrono>
 
 #if defined(_WIN32)
 #include <windows.h>
@@ -344,9 +346,28 @@ public:
         }
         /* 确定每一个部件的大小 */
         performLayout(mSDL_Renderer);
+        mProgressBar = handle<ProgressBar>("progressbar");
+
+        /* 模拟后台线程产生的数据, 通过 post() 交给 UI 线程更新进度条 */
+        mWorker = std::thread([this] {
+          while (mRunning)
+          {
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            post([this] {
+              if (auto pbar = mProgressBar.get())
+              {
+                pbar->setValue(pbar->value() + 0.001f);
+                if (pbar->value() >= 1.f)
+                  pbar->setValue(0.f);
+              }
+            });
+          }
+        });
     }
 
     ~TestWindow() {
+      mRunning = false;
+      mWorker.join();
     }
 
     virtual bool keyboardEvent(int key, int scancode, int action, int modifiers)
@@ -362,25 +383,15 @@ public:
         return false;
     }
 
-    virtual void draw(SDL_Renderer* renderer)
-    {
-      if (auto pbar = gfind<ProgressBar>("progressbar"))
-      {
-        /* 更新 progressbar 进度条更新 */
-        pbar->setValue(pbar->value() + 0.001f);
-        if (pbar->value() >= 1.f)
-          pbar->setValue(0.f);
-      }
-
-      Screen::draw(renderer);
-    }
-
     virtual void drawContents()
     {
     }
 private:
     std::vector<SDL_Texture*> mImagesData;
     int mCurrentImage;
+    WidgetHandle<ProgressBar> mProgressBar;
+    std::thread mWorker;
+    std::atomic<bool> mRunning{ true };
 };
 
 
@@ -468,6 +479,8 @@ int main(int /* argc */, char ** /* argv */)
     TestWindow *screen = new TestWindow(window, winWidth, winHeight);
 
     Fps fps;
+    WidgetHandle<Window> swindow = screen->handle<Window>("sWindow");
+    WidgetHandle<Label> hspeed_value = screen->handle<Label>("hspeed");
 
     bool quit = false;
     try
@@ -492,13 +505,11 @@ int main(int /* argc */, char ** /* argv */)
 
             /* 绘制内容 */
             screen->drawAll();
-            Window * swindow = dynamic_cast<Window *>(screen->gfind("sWindow"));
             static int test;
             if (swindow)
             {
-              if (test++ % 30 == 1)
+              if (test++ % 30 == 1 && hspeed_value)
               {
-                Label *hspeed_value = dynamic_cast<Label *>(swindow->gfind("hspeed"));
                 hspeed_value->setCaption(std::to_string(test) + '/' + std::to_string(test+1));
               }
             }
@@ -78,6 +78,7 @@ Button::Button(Widget *parent, const std::string &caption, int icon)
       mFlags(NormalButton) /* 初始就是 normal button */, mBackgroundColor(Color(0, 0)),
       mTextColor(Color(0, 0)) 
 {
+  mKind |= ButtonKind;
   _captionTex.dirty = true;
   _iconTex.dirty = true;
 }
@@ -127,7 +128,7 @@ bool Button::mouseButtonEvent(const Vector2i &p, int button, bool down, int modi
                 {
                     for (auto widget : parent()->children()) 
                     {
-                        Button *b = dynamic_cast<Button *>(widget);
+                        Button *b = fast_cast<Button>(widget);
                         if (b != this && b && (b->flags() & RadioButton) && b->mPushed) 
                         {
                             b->mPushed = false;
@@ -155,7 +156,7 @@ bool Button::mouseButtonEvent(const Vector2i &p, int button, bool down, int modi
             {
                 for (auto widget : parent()->children()) 
                 {
-                    Button *b = dynamic_cast<Button *>(widget);
+                    Button *b = fast_cast<Button>(widget);
                     if (b != this && b && (b->flags() & PopupButton) && b->mPushed) 
                     {
                         b->mPushed = false;
@@ -290,7 +291,7 @@ void Button::drawBody(SDL_Renderer* renderer)
   }
   else
   {
-    AsyncTexturePtr newtx = std::make_shared<AsyncTexture>(id);
+    AsyncTexturePtr newtx = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>(), id);
     newtx->load(this);
     _txs.push_back(newtx);
 
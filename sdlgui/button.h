@@ -48,7 +48,7 @@ public:
       : Button(parent, caption) { setChangeCallback(callback); }
 
     const std::string &caption() const { return mCaption; }
-    void setCaption(const std::string &caption) { mCaption = caption; _captionTex.dirty = true; }
+    void setCaption(const std::string &caption) { mCaption = caption; _captionTex.dirty = true; invalidateLayout(); }
 
     const Color &backgroundColor() const { return mBackgroundColor; }
     void setBackgroundColor(const Color &backgroundColor) { mBackgroundColor = backgroundColor; }
@@ -57,13 +57,13 @@ public:
     void setTextColor(const Color &textColor);
 
     int icon() const { return mIcon; }
-    void setIcon(int icon) { mIcon = icon; }
+    void setIcon(int icon) { mIcon = icon; invalidateLayout(); }
 
     int flags() const { return mFlags; }
     void setFlags(int buttonFlags) { mFlags = buttonFlags; }
 
     IconPosition iconPosition() const { return mIconPosition; }
-    void setIconPosition(IconPosition iconPosition) { mIconPosition = iconPosition; }
+    void setIconPosition(IconPosition iconPosition) { mIconPosition = iconPosition; invalidateLayout(); }
 
     bool pushed() const { return mPushed; }
     void setPushed(bool pushed) { mPushed = pushed; }
@@ -122,4 +122,6 @@ protected:
     std::vector<AsyncTexturePtr> _txs;
 };
 
+template<> struct WidgetKindOf<Button> { enum { value = Widget::ButtonKind }; };
+
 NAMESPACE_END(sdlgui)
@@ -157,7 +157,7 @@ void CheckBox::drawBody(SDL_Renderer* renderer)
   }
   else
   {
-    AsyncTexturePtr newtx = std::make_shared<AsyncTexture>(id);
+    AsyncTexturePtr newtx = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>(), id);
     newtx->load(this, mPushed, mMouseFocus, mEnabled);
     _txs.push_back(newtx);
   }
@@ -23,7 +23,7 @@ public:
              const std::function<void(bool)> &callback = std::function<void(bool)>());
 
     const std::string &caption() const { return mCaption; }
-    void setCaption(const std::string &caption) { mCaption = caption; }
+    void setCaption(const std::string &caption) { mCaption = caption; invalidateLayout(); }
 
     const bool &checked() const { return mChecked; }
     void setChecked(const bool &checked) { mChecked = checked; }
@@ -75,6 +75,25 @@ SDL_Rect clip_rects(SDL_Rect af, const SDL_Rect& bf)
   return { a.x1, a.y1, a.x2 - a.x1, a.y2 - a.y1 };
 }
 
+RenderClipScope::RenderClipScope(SDL_Renderer* renderer, const SDL_Rect& rect)
+  : mRenderer(renderer), mSaved{ 0, 0, 0, 0 }, mEnabled(SDL_RenderIsClipEnabled(renderer) == SDL_TRUE)
+{
+  SDL_Rect clip = rect;
+  if (mEnabled)
+  {
+    SDL_RenderGetClipRect(renderer, &mSaved);
+    clip = clip_rects(clip, mSaved);
+  }
+  clip.w = std::max(0, clip.w);
+  clip.h = std::max(0, clip.h);
+  SDL_RenderSetClipRect(renderer, &clip);
+}
+
+RenderClipScope::~RenderClipScope()
+{
+  SDL_RenderSetClipRect(mRenderer, mEnabled ? &mSaved : nullptr);
+}
+
 PntRect clip_rects(PntRect a, const PntRect& b)
 {
   if (a.x1 < b.x1)
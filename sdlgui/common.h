@@ -72,10 +72,49 @@ typedef std::vector<ImageInfo> ListImages;
 /// Load a directory of PNG images and upload them to the GPU (suitable for use with ImagePanel)
 ListImages loadImageDirectory(SDL_Renderer* renderer, const std::string &path);
 
+/// Counters of the small object pool, see \ref poolAllocate
+struct PoolStats
+{
+  size_t allocations = 0; ///< Blocks handed out since start
+  size_t frees = 0;       ///< Blocks returned since start
+  size_t live = 0;        ///< Blocks in use
+  size_t chunks = 0;      ///< Chunks reserved from the heap
+  size_t bytes = 0;       ///< Bytes reserved by the chunks
+};
+
+/**
+ * Allocate \p size bytes. Small sizes are served from per-size free lists carved
+ * out of large chunks, so the many small widgets, layouts and textures of a
+ * screen do not fragment the heap. Each thread allocates from its own pool
+ * without locking; a thread's pool is handed over to the next new thread when it exits.
+ */
+void *poolAllocate(size_t size);
+/// Return a block from \ref poolAllocate; \p size must be the size it was allocated with.
+/// A block freed on another thread is queued back to the pool that allocated it
+void poolFree(void *ptr, size_t size) noexcept;
+/// Release in bulk the chunks of the calling thread's pool, and of the pools no thread
+/// owns, whose blocks are all free; returns the number of chunks released
+size_t poolTrim();
+PoolStats poolStats();
+
+/// Standard allocator on top of \ref poolAllocate, e.g. for std::allocate_shared
+template <typename T> struct PoolAllocator
+{
+  typedef T value_type;
+  PoolAllocator() { }
+  template <typename U> PoolAllocator(const PoolAllocator<U> &) { }
+  T *allocate(size_t n) { return (T *) poolAllocate(n * sizeof(T)); }
+  void deallocate(T *p, size_t n) noexcept { poolFree(p, n * sizeof(T)); }
+  template <typename U> bool operator==(const PoolAllocator<U> &) const { return true; }
+  template <typename U> bool operator!=(const PoolAllocator<U> &) const { return false; }
+};
+
 /**
 * \class Object object.h sdlgui/object.h
 *
 * \brief Reference counted object base class.
+*
+* Objects are allocated with \ref poolAllocate.
 */
 class Object
 {
@@ -99,6 +138,9 @@ public:
   * the reference count reaches zero.
   */
   void decRef(bool dealloc = true) const noexcept;
+
+  static void *operator new(size_t size) { return poolAllocate(size); }
+  static void operator delete(void *ptr, size_t size) noexcept { poolFree(ptr, size); }
 protected:
   /** \brief Virtual protected deconstructor.
   * (Will only be called by \ref ref)
@@ -336,6 +378,21 @@ PntRect clip_rects(PntRect a, const PntRect& b);
 PntRect srect2pntrect(const SDL_Rect& srect);
 SDL_Rect pntrect2srect(const PntRect& frect);
 
+/* 作用域内把 renderer 的裁剪区域设为 rect 和当前裁剪区域的交集, 离开作用域时恢复 */
+struct RenderClipScope
+{
+  RenderClipScope(SDL_Renderer* renderer, const SDL_Rect& rect);
+  ~RenderClipScope();
+
+  RenderClipScope(const RenderClipScope&) = delete;
+  RenderClipScope& operator=(const RenderClipScope&) = delete;
+
+private:
+  SDL_Renderer* mRenderer;
+  SDL_Rect mSaved;
+  bool mEnabled;
+};
+
 std::string  file_dialog(const std::vector<std::pair<std::string, std::string>> &filetypes, bool save);
 
 
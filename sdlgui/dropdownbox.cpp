@@ -157,8 +157,8 @@ public:
     Vector2i screenSize = screen->size();
 
     /* 这里会更新 _pos */
-    _pos = mParentWindow->position() + mAnchorPos;
-    _pos = Vector2i(_pos.x, std::min(_pos.y, screen->size().y - mSize.y));
+    Vector2i pos = mParentWindow->position() + mAnchorPos;
+    setPosition(Vector2i(pos.x, std::min(pos.y, screen->size().y - mSize.y)));
 
   }
 
@@ -11,6 +11,7 @@
 #include <sdlgui/graph.h>
 #include <sdlgui/theme.h>
 #include <thread>
+#include <mutex>
 
 #include "nanovg.h"
 #define NANOVG_RT_IMPLEMENTATION
@@ -45,11 +46,27 @@ struct Graph::AsyncTexture
       nvgFill(ctx);
 
       if (graph->values().size() < 2)
+      {
+        nvgDeleteRT(ctx);
         return;
+      }
 
       nvgBeginPath(ctx);
       nvgMoveTo(ctx, 0, 0 + hh);
       auto& values = graph->values();
+      if (values.size() > (size_t)ww * 2)
+      {
+        /* 采样比像素多时每列只取最小和最大值, 路径的顶点数和宽度成正比 */
+        for (int x = 0; x < ww; x++)
+        {
+          size_t b = (size_t)x * values.size() / ww;
+          size_t e = std::max(b + 1, (size_t)(x + 1) * values.size() / ww);
+          auto mm = std::minmax_element(values.begin() + b, values.begin() + e);
+          nvgLineTo(ctx, x, (1 - *mm.second) * hh);
+          nvgLineTo(ctx, x, (1 - *mm.first) * hh);
+        }
+      }
+      else
       for (size_t i = 0; i < (size_t)values.size(); i++) 
       {
         float value = values[i];
@@ -80,6 +97,8 @@ struct Graph::AsyncTexture
 
     unsigned char *rgba = nvgReadPixelsRT(ctx);
 
+    if (tex.tex)
+      SDL_DestroyTexture(tex.tex);
     tex.tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING, tex.w(), tex.h());
 
     int pitch;
@@ -94,6 +113,228 @@ struct Graph::AsyncTexture
   }
 };
 
+/*
+ * 环形缓冲的实时曲线: 纹理的每一列对应环形缓冲中的一个采样, 新的采样只光栅化
+ * 对应的几列并用 SDL_UpdateTexture 上传. 绘制时从最旧的一列开始分两段拷贝,
+ * 效果相当于把整个纹理向左平移, 但不需要移动任何像素.
+ */
+struct Graph::Ring
+{
+  mutable std::mutex mutex;
+  std::vector<float> values;
+  size_t head = 0;        /* 下一个写入位置 */
+  size_t count = 0;
+  size_t unrendered = 0;  /* 还没有画到纹理上的采样数 */
+  /* update 时纹理对应的 head/count, draw 只用这份快照, 不读正在被 append 修改的值 */
+  size_t drawnHead = 0;
+  size_t drawnCount = 0;
+
+  SDL_Texture* tex = nullptr;
+  int texHeight = 0;
+  std::vector<uint32_t> columns;
+
+  /* 纹理不在析构函数中释放: 最后一个引用可能在调用 append 的线程上.
+   * 由 Graph 在绘制线程中调用 release */
+  void release()
+  {
+    if (tex)
+      SDL_DestroyTexture(tex);
+    tex = nullptr;
+  }
+
+  static uint32_t argb(const Color& c)
+  {
+    SDL_Color sc = c.toSdlColor();
+    return ((uint32_t)sc.a << 24) | ((uint32_t)sc.r << 16) | ((uint32_t)sc.g << 8) | sc.b;
+  }
+
+  /* 光栅化一列: 背景, 前景填充, 以及连接上一个采样的竖线 */
+  static void rasterize(uint32_t* column, int pitch, int hh, float value, float prev,
+                        uint32_t bg, uint32_t fg, uint32_t stroke)
+  {
+    int y = std::max(0, std::min(hh - 1, (int)((1 - value) * hh)));
+    int py = std::max(0, std::min(hh - 1, (int)((1 - prev) * hh)));
+    int s0 = std::min(y, py), s1 = std::max(y, py);
+    for (int row = 0; row < hh; row++)
+    {
+      uint32_t c = row < y ? bg : fg;
+      if (row >= s0 && row <= s1)
+        c = stroke;
+      column[row * pitch] = c;
+    }
+  }
+
+  void update(SDL_Renderer* renderer, Graph* graph)
+  {
+    int hh = graph->height();
+    size_t cap = values.size();
+    if (hh <= 0 || cap == 0)
+      return;
+
+    /* 高度或容量变化时重建纹理, 所有采样重新光栅化 */
+    std::lock_guard<std::mutex> guard(mutex);
+    if (!tex || hh != texHeight)
+    {
+      if (tex)
+        SDL_DestroyTexture(tex);
+      tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, (int)cap, hh);
+      if (!tex)
+        return;
+      SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+      texHeight = hh;
+      unrendered = cap;
+    }
+    if (unrendered == 0)
+      return;
+
+    uint32_t bg = argb(graph->backgroundColor());
+    uint32_t fg = argb(graph->foregroundColor());
+    uint32_t stroke = argb(Color(100, 255));
+
+    /* 需要重画的是环形缓冲中 head 之前的 n 列, 可能分成两段 */
+    size_t n = std::min(unrendered, cap);
+    size_t first = (head + cap - n) % cap;
+    while (n > 0)
+    {
+      size_t run = std::min(n, cap - first);
+      columns.resize(run * hh);
+      for (size_t i = 0; i < run; i++)
+      {
+        size_t pos = first + i;
+        size_t age = (head + cap - pos - 1) % cap;   /* 0 是最新的采样 */
+        bool valid = age < count;
+        float value = valid ? values[pos] : 0.f;
+        float prev = (valid && age + 1 < count) ? values[(pos + cap - 1) % cap] : value;
+        if (valid)
+          rasterize(&columns[i], (int)run, hh, value, prev, bg, fg, stroke);
+        else
+          for (int row = 0; row < hh; row++)
+            columns[i + row * run] = bg;
+      }
+      SDL_Rect rect{ (int)first, 0, (int)run, hh };
+      SDL_UpdateTexture(tex, &rect, columns.data(), (int)(run * sizeof(uint32_t)));
+      first = (first + run) % cap;
+      n -= run;
+    }
+    unrendered = 0;
+    drawnHead = head;
+    drawnCount = count;
+  }
+
+  void draw(SDL_Renderer* renderer, const Vector2i& ap, const Vector2i& size)
+  {
+    size_t cap = values.size();
+    if (!tex || cap == 0)
+      return;
+
+    /* 缓冲没满时从左边开始画, 满了以后最旧的一列 (head) 在最左边 */
+    size_t oldest = drawnCount < cap ? 0 : drawnHead;
+    int split = (int)std::round((cap - oldest) * size.x / (float)cap);
+    SDL_Rect src1{ (int)oldest, 0, (int)(cap - oldest), texHeight };
+    SDL_Rect dst1{ ap.x, ap.y, split, size.y };
+    SDL_RenderCopy(renderer, tex, &src1, &dst1);
+    if (oldest > 0)
+    {
+      SDL_Rect src2{ 0, 0, (int)oldest, texHeight };
+      SDL_Rect dst2{ ap.x + split, ap.y, size.x - split, size.y };
+      SDL_RenderCopy(renderer, tex, &src2, &dst2);
+    }
+  }
+};
+
+/*
+ * 多分辨率的 min/max 汇总: 第 0 层是原始采样, 第 k 层的每一项是第 k-1 层相邻
+ * 两项的最小和最大值. 追加采样时逐层进位, 绘制时选取每个像素对应一到两项的那
+ * 一层, 开销只和宽度有关.
+ */
+struct Graph::Plot
+{
+  struct Range
+  {
+    float min, max;
+    void merge(const Range& o) { min = std::min(min, o.min); max = std::max(max, o.max); }
+  };
+
+  struct Series
+  {
+    Color color;
+    std::vector<std::vector<Range>> levels;
+
+    size_t size() const { return levels.empty() ? 0 : levels[0].size(); }
+
+    void append(float value)
+    {
+      if (levels.empty())
+        levels.emplace_back();
+      levels[0].push_back(Range{ value, value });
+      for (size_t k = 0; levels[k].size() % 2 == 0; k++)
+      {
+        const std::vector<Range>& lower = levels[k];
+        Range r = lower[lower.size() - 2];
+        r.merge(lower.back());
+        if (k + 1 == levels.size())
+          levels.emplace_back();
+        levels[k + 1].push_back(r);
+      }
+    }
+
+    /* 原始采样 [begin, end) 的最小和最大值 */
+    Range range(size_t begin, size_t end) const
+    {
+      Range r{ 1e30f, -1e30f };
+      int k = (int)levels.size() - 1;
+      while (begin < end)
+      {
+        /* 取能对齐 begin 并且不超出 end 的最大块 */
+        while (k > 0 && (((begin >> k) << k) != begin || begin + ((size_t)1 << k) > end
+                         || (begin >> k) >= levels[k].size()))
+          k--;
+        r.merge(levels[k][begin >> k]);
+        begin += (size_t)1 << k;
+        k = std::min((int)levels.size() - 1, k + 1);
+      }
+      return r;
+    }
+  };
+
+  mutable std::mutex mutex;
+  std::vector<Series> series;
+  std::vector<SDL_Point> points;
+
+  void draw(SDL_Renderer* renderer, const Vector2i& ap, const Vector2i& size)
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    int ww = size.x, hh = size.y;
+    if (ww <= 0 || hh <= 0)
+      return;
+
+    for (auto& s : series)
+    {
+      size_t n = s.size();
+      if (n < 2)
+        continue;
+
+      /* 每个像素列画一条从最大值到最小值的竖线, 相邻列连起来 */
+      points.clear();
+      int columns = (int)std::min((size_t)ww, n);
+      for (int x = 0; x < columns; x++)
+      {
+        size_t b = (size_t)x * n / columns;
+        size_t e = std::max(b + 1, (size_t)(x + 1) * n / columns);
+        Range r = s.range(b, e);
+        int px = ap.x + (columns == ww ? x : (int)((int64_t)x * (ww - 1) / (columns - 1)));
+        points.push_back(SDL_Point{ px, ap.y + (int)((1 - r.max) * (hh - 1)) });
+        if (r.min != r.max)
+          points.push_back(SDL_Point{ px, ap.y + (int)((1 - r.min) * (hh - 1)) });
+      }
+
+      SDL_Color c = s.color.toSdlColor();
+      SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+      SDL_RenderDrawLines(renderer, points.data(), (int)points.size());
+    }
+  }
+};
+
 Graph::Graph(Widget *parent, const std::string &caption)
     : Widget(parent), mCaption(caption) 
 {
@@ -104,6 +345,137 @@ Graph::Graph(Widget *parent, const std::string &caption)
     _headerTex.dirty = true;
 }
 
+Graph::~Graph()
+{
+    /* Graph 在绘制线程中销毁, 这里释放所有 ring 的纹理 */
+    std::lock_guard<std::mutex> guard(mRingMutex);
+    for (auto& ring : _retiredRings)
+      ring->release();
+    if (_ring)
+      _ring->release();
+}
+
+Graph::RingPtr Graph::ring() const
+{
+    std::lock_guard<std::mutex> guard(mRingMutex);
+    return _ring;
+}
+
+size_t Graph::capacity() const
+{
+    RingPtr ring = this->ring();
+    if (!ring)
+      return 0;
+    std::lock_guard<std::mutex> guard(ring->mutex);
+    return ring->values.size();
+}
+
+void Graph::setCapacity(size_t capacity)
+{
+    RingPtr ring;
+    if (capacity > 0)
+    {
+      ring = std::make_shared<Ring>();
+      ring->values.assign(capacity, 0.f);
+    }
+
+    std::lock_guard<std::mutex> guard(mRingMutex);
+    if (_ring)
+      _retiredRings.push_back(_ring);
+    _ring = ring;
+}
+
+void Graph::append(const float *values, size_t count)
+{
+    RingPtr ring = this->ring();
+    if (!ring)
+      return;
+
+    std::lock_guard<std::mutex> guard(ring->mutex);
+    size_t cap = ring->values.size();
+    for (size_t i = 0; i < count; i++)
+    {
+      ring->values[ring->head] = values[i];
+      ring->head = (ring->head + 1) % cap;
+    }
+    ring->count = std::min(cap, ring->count + count);
+    /* 上一列的竖线依赖新的采样, 所以多重画一列 */
+    ring->unrendered = std::min(cap, ring->unrendered + count + 1);
+}
+
+std::vector<float> Graph::samples() const
+{
+    std::vector<float> result;
+    RingPtr ring = this->ring();
+    if (!ring)
+      return result;
+
+    std::lock_guard<std::mutex> guard(ring->mutex);
+    size_t cap = ring->values.size();
+    for (size_t i = 0; i < ring->count; i++)
+      result.push_back(ring->values[(ring->head + cap - ring->count + i) % cap]);
+    return result;
+}
+
+Graph::PlotPtr Graph::plot() const
+{
+    std::lock_guard<std::mutex> guard(mRingMutex);
+    return _plot;
+}
+
+int Graph::addSeries(const Color &color)
+{
+    PlotPtr plot;
+    {
+      std::lock_guard<std::mutex> guard(mRingMutex);
+      if (!_plot)
+        _plot = std::make_shared<Plot>();
+      plot = _plot;
+    }
+    std::lock_guard<std::mutex> guard(plot->mutex);
+    plot->series.emplace_back();
+    plot->series.back().color = color;
+    return (int)plot->series.size() - 1;
+}
+
+void Graph::appendSeries(int index, const float *values, size_t count)
+{
+    PlotPtr plot = this->plot();
+    if (!plot)
+      return;
+    std::lock_guard<std::mutex> guard(plot->mutex);
+    if (index < 0 || index >= (int)plot->series.size())
+      return;
+    for (size_t i = 0; i < count; i++)
+      plot->series[index].append(values[i]);
+}
+
+int Graph::seriesCount() const
+{
+    PlotPtr plot = this->plot();
+    if (!plot)
+      return 0;
+    std::lock_guard<std::mutex> guard(plot->mutex);
+    return (int)plot->series.size();
+}
+
+size_t Graph::seriesSize(int index) const
+{
+    PlotPtr plot = this->plot();
+    if (!plot)
+      return 0;
+    std::lock_guard<std::mutex> guard(plot->mutex);
+    if (index < 0 || index >= (int)plot->series.size())
+      return 0;
+    return plot->series[index].size();
+}
+
+void Graph::clearSeries()
+{
+    std::lock_guard<std::mutex> guard(mRingMutex);
+    _plot = nullptr;
+}
+
 Vector2i Graph::preferredSize(SDL_Renderer *) const
 {
     return Vector2i(180, 45);
@@ -114,8 +486,23 @@ void Graph::draw(SDL_Renderer *renderer)
     Widget::draw(renderer);
 
     Vector2i ap = absolutePosition();
-    
-    if (_atx)
+
+    RingPtr ring;
+    std::vector<RingPtr> retired;
+    {
+      std::lock_guard<std::mutex> guard(mRingMutex);
+      ring = _ring;
+      retired.swap(_retiredRings);
+    }
+    for (auto& r : retired)
+      r->release();
+
+    if (ring)
+    {
+      ring->update(renderer, this);
+      ring->draw(renderer, ap, mSize);
+    }
+    else if (_atx)
     {
       Vector2i ap = absolutePosition();
       _atx->perform(renderer);
@@ -123,10 +510,13 @@ void Graph::draw(SDL_Renderer *renderer)
     }
     else
     {
-      _atx = std::make_shared<AsyncTexture>();
+      _atx = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>());
       _atx->load(this);
     }
 
+    if (PlotPtr plot = this->plot())
+      plot->draw(renderer, ap, mSize);
+
     if (_captionTex.dirty)
       mTheme->getTexAndRectUtf8(renderer, _captionTex, 0, 0, mCaption.c_str(), "sans", 14, mTextColor);
 
@@ -12,6 +12,7 @@
 
 #include <sdlgui/widget.h>
 #include <memory>
+#include <mutex>
 
 NAMESPACE_BEGIN(sdlgui)
 
@@ -19,6 +20,7 @@ class  Graph : public Widget
 {
 public:
     Graph(Widget *parent, const std::string &caption = "Untitled");
+    ~Graph();
 
     const std::string &caption() const { return mCaption; }
     void setCaption(const std::string &caption) { mCaption = caption; _captionTex.dirty = true; }
@@ -42,6 +44,36 @@ public:
     std::vector<float>  &values() { return mValues; }
     void setValues(const  std::vector<float>  &values) { mValues = values; }
 
+    /// Number of samples kept by \ref append; 0 means \ref values is plotted instead
+    size_t capacity() const;
+    /// Plot the last \p capacity appended samples, discarding the ones already appended
+    void setCapacity(size_t capacity);
+    Graph& withCapacity(size_t capacity) { setCapacity(capacity); return *this; }
+
+    /// Append a sample in the 0..1 range; safe to call from any thread
+    void append(float value) { append(&value, 1); }
+    /// Append \p count samples in the 0..1 range; safe to call from any thread
+    void append(const float *values, size_t count);
+
+    /// Return the samples in the ring buffer, oldest first
+    std::vector<float> samples() const;
+
+    /**
+     * Add a series drawn as a line of \p color over the whole graph width and return
+     * its index. Series keep every sample together with a min/max summary at several
+     * resolutions, so drawing costs the same for a thousand or millions of samples.
+     */
+    int addSeries(const Color &color);
+    /// Append \p count samples in the 0..1 range to series \p index; safe to call from any thread
+    void appendSeries(int index, const float *values, size_t count);
+    void appendSeries(int index, float value) { appendSeries(index, &value, 1); }
+    /// Number of series
+    int seriesCount() const;
+    /// Number of samples in series \p index
+    size_t seriesSize(int index) const;
+    /// Remove all the series
+    void clearSeries();
+
     Vector2i preferredSize(SDL_Renderer *ctx) const override;
     void draw(SDL_Renderer *ctx) override;
 
@@ -57,6 +89,21 @@ protected:
     struct AsyncTexture;
     typedef std::shared_ptr<AsyncTexture> AsyncTexturePtr;
     AsyncTexturePtr _atx;
+
+    struct Ring;
+    typedef std::shared_ptr<Ring> RingPtr;
+    /* _ring 可能被其他线程 (append/samples) 读取, 读写指针时持有 mRingMutex */
+    mutable std::mutex mRingMutex;
+    RingPtr _ring;
+    /* setCapacity 换下来的 ring, 纹理只能在绘制线程中释放 */
+    std::vector<RingPtr> _retiredRings;
+    RingPtr ring() const;
+
+    struct Plot;
+    typedef std::shared_ptr<Plot> PlotPtr;
+    /* 和 _ring 一样, 读写指针时持有 mRingMutex */
+    PlotPtr _plot;
+    PlotPtr plot() const;
 };
 
 NAMESPACE_END(sdlgui)
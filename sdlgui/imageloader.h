@@ -0,0 +1,87 @@
+/*
+    sdlgui/imageloader.h -- Loads a directory of images on worker threads
+
+    Based on NanoGUI by Wenzel Jakob <wenzel@inf.ethz.ch>.
+    Adaptation for SDL by Dalerank <dalerankn8@gmail.com>
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <sdlgui/common.h>
+#include <memory>
+
+NAMESPACE_BEGIN(sdlgui)
+
+/**
+ * \class ImageLoader imageloader.h sdlgui/imageloader.h
+ *
+ * \brief Asynchronous variant of \ref loadImageDirectory.
+ *
+ * The PNG images of a directory are decoded in parallel on worker threads. The
+ * textures are created on the render thread by \ref upload, a few per frame, so
+ * the caller can show the images as they arrive.
+ *
+ * In on-demand mode nothing is decoded until \ref request is called, and the
+ * loader owns the textures: \ref release destroys one, the destructor the rest.
+ */
+class ImageLoader : public Object
+{
+public:
+    /**
+     * Start decoding the PNG images in \p path; \p threads <= 0 picks one per core.
+     * When \p thumbSize is positive, only a thumbnail whose short side is \p thumbSize
+     * is kept for each image. Thumbnails are stored in \p cacheDir (if not empty),
+     * keyed by a hash of the image file, so the originals are not decoded again.
+     */
+    ImageLoader(const std::string &path, int threads = 0, int thumbSize = 0,
+                const std::string &cacheDir = "", bool onDemand = false);
+
+    /// Stop the workers, free the images that were not uploaded and, in on-demand mode, the textures
+    ~ImageLoader();
+
+    /// Number of images found in the directory
+    int total() const;
+
+    /// Number of distinct images handled by \ref upload so far, decoded or failed;
+    /// an image released and uploaded again in on-demand mode is counted once
+    int loaded() const;
+
+    /// Has every image been handled at least once? In on-demand mode this only
+    /// becomes true once every image has been requested
+    bool done() const { return loaded() >= total(); }
+
+    /// Images uploaded so far, in directory order; failed images have no texture
+    const ListImages &images() const { return mImages; }
+
+    /**
+     * Create the textures of at most \p maxImages decoded images. Must be called
+     * from the render thread, typically once per frame. Returns the number of
+     * images handled.
+     */
+    int upload(SDL_Renderer *renderer, int maxImages = 8);
+
+    /// Queue image \p index for decoding if it has no texture; newest requests are served first
+    void request(int index);
+
+    /// Drop the requests that no worker has started yet
+    void clearRequests();
+
+    /// Destroy the texture of image \p index; it can be requested again later
+    void release(int index);
+
+    /// Called from \ref upload with the directory index and the image once its texture exists
+    void setCallback(const std::function<void(int, const ImageInfo &)> &callback) { mCallback = callback; }
+    const std::function<void(int, const ImageInfo &)> &callback() const { return mCallback; }
+
+private:
+    struct Workers;
+    std::unique_ptr<Workers> mWorkers;
+    ListImages mImages;
+    std::function<void(int, const ImageInfo &)> mCallback;
+};
+
+NAMESPACE_END(sdlgui)
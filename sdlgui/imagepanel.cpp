@@ -20,12 +20,42 @@ ImagePanel::ImagePanel(Widget *parent)
 {
 }
 
+void ImagePanel::loadImageDirectory(const std::string &path, int threads)
+{
+    mImages.clear();
+    mResident.clear();
+    mLoader = new ImageLoader(path, threads, mThumbSize, mThumbnailCache, true);
+    mLastSeen.assign(mLoader->total(), 0);
+    mLoader->setCallback([this](int index, const ImageInfo&) { mResident.push_back(index); });
+    invalidateLayout();
+}
+
+/* 纹理超过 mMaxResident 时释放最久没有显示过的 */
+void ImagePanel::evictImages()
+{
+    if (!mLoader || (int)mResident.size() <= mMaxResident)
+        return;
+
+    size_t count = mResident.size() - mMaxResident;
+    std::nth_element(mResident.begin(), mResident.begin() + count, mResident.end(),
+                     [this](int a, int b) { return mLastSeen[a] < mLastSeen[b]; });
+    for (size_t i = 0; i < count; i++)
+    {
+        /* 当前帧可见的不释放 */
+        if (mLastSeen[mResident[i]] == mFrame)
+            continue;
+        mLoader->release(mResident[i]);
+        mResident[i] = -1;
+    }
+    mResident.erase(std::remove(mResident.begin(), mResident.end(), -1), mResident.end());
+}
+
 Vector2i ImagePanel::gridSize() const
 {
     int nCols = 1 + std::max(0,
         (int) ((mSize.x - 2 * mMargin - mThumbSize) /
         (float) (mThumbSize + mSpacing)));
-    int nRows = ((int) mImages.size() + nCols - 1) / nCols;
+    int nRows = ((int) images().size() + nCols - 1) / nCols;
     return Vector2i(nCols, nRows);
 }
 
@@ -48,6 +78,14 @@ bool ImagePanel::mouseMotionEvent(const Vector2i &p, const Vector2i & /* rel */,
     return true;
 }
 
+/* 离开时不会再收到 motion 事件, 在这里清掉高亮 */
+bool ImagePanel::mouseEnterEvent(const Vector2i &p, bool enter)
+{
+    if (!enter)
+        mMouseIndex = -1;
+    return Widget::mouseEnterEvent(p, enter);
+}
+
 bool ImagePanel::mouseButtonEvent(const Vector2i &p, int /* button */, bool down,
                                   int /* modifiers */) 
 {
@@ -66,85 +104,137 @@ Vector2i ImagePanel::preferredSize(SDL_Renderer *) const
     };
 }
 
-void ImagePanel::draw(SDL_Renderer* renderer) 
+void ImagePanel::drawImage(SDL_Renderer* renderer, const ImageInfo& image, const Vector2i& p,
+                           const PntRect& clip, const SDL_Rect& clipRect)
 {
-  Vector2i grid = gridSize();
+    int imgw = image.w;
+    int imgh = image.h;
+    if (!image.tex || imgw <= 0 || imgh <= 0)
+    {
+        /* 还没有加载的图像只画边框 */
+        SDL_Rect brect{ p.x + 1, p.y + 1, mThumbSize - 2, mThumbSize - 2};
+        brect = clip_rects(brect, clipRect);
+        if (brect.w > 0 && brect.h > 0)
+        {
+          SDL_SetRenderDrawColor(renderer, 0xff, 0xff, 0xff, 40);
+          SDL_RenderDrawRect(renderer, &brect);
+        }
+        return;
+    }
 
-    int ax = getAbsoluteLeft();
-    int ay = getAbsoluteTop();
+    float iw, ih, ix, iy;
+    if (imgw < imgh) 
+    {
+        iw = mThumbSize;
+        ih = iw * (float)imgh / (float)imgw;
+        ix = 0;
+        iy = -(ih - mThumbSize) * 0.5f;
+    } 
+    else 
+    {
+        ih = mThumbSize;
+        iw = ih * (float)imgw / (float)imgh;
+        ix = -(iw - mThumbSize) * 0.5f;
+        iy = 0;
+    }
 
-    PntRect clip = getAbsoluteCliprect();
-    SDL_Rect clipRect = pntrect2srect(clip);
+    //, 0, image.first, mMouseIndex == (int)i ? 1.0 : 0.7);
 
-    for (size_t i=0; i<mImages.size(); ++i) 
+    SDL_Color c{ 0, 0, 0, 128 };
+    SDL_Rect shadowPaintRect{ p.x - 1, p.y, mThumbSize + 2, mThumbSize + 2 };
+
+    shadowPaintRect = clip_rects(shadowPaintRect, clipRect);
+
+    if (shadowPaintRect.w > 0 && shadowPaintRect.h > 0)
     {
-      Vector2i p = Vector2i(mMargin, mMargin) + Vector2i((int) i % grid.x, (int) i / grid.x) * (mThumbSize + mSpacing);
-        p += Vector2i(ax, ay);
-        int imgw = mImages[i].w;
-        int imgh = mImages[i].h;
+      SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+      SDL_RenderFillRect(renderer, &shadowPaintRect);
+    }
 
-        float iw, ih, ix, iy;
-        if (imgw < imgh) 
-        {
-            iw = mThumbSize;
-            ih = iw * (float)imgh / (float)imgw;
-            ix = 0;
-            iy = -(ih - mThumbSize) * 0.5f;
-        } 
-        else 
-        {
-            ih = mThumbSize;
-            iw = ih * (float)imgw / (float)imgh;
-            ix = -(iw - mThumbSize) * 0.5f;
-            iy = 0;
-        }
+    SDL_Rect imgPaintRect{
+        (int)std::round(p.x + ix),
+        (int)std::round(p.y + iy),
+        (int)std::round(iw),
+        (int)std::round(ih)
+    };
+    SDL_Rect imgSrcRect{ 0, 0, imgw, imgh };
+    PntRect imgrect = clip_rects(srect2pntrect(imgPaintRect), clip);
+    imgPaintRect.w = imgrect.x2 - imgrect.x1;
+    imgPaintRect.h = imgrect.y2 - imgrect.y1;
+    if (imgPaintRect.y < clip.y1)
+    {
+      imgPaintRect.y = clip.y1;
+      imgSrcRect.h = (imgPaintRect.h / (float)ih) * imgh;
+      imgSrcRect.y = (1 - (imgPaintRect.h / (float)ih)) * imgh;
+    }
+    else if(imgPaintRect.h < ih)
+    {
+      imgSrcRect.h = (imgPaintRect.h / (float)ih) * imgh;
+    }
 
-        //, 0, mImages[i].first, mMouseIndex == (int)i ? 1.0 : 0.7);
+    /* 绘制图像内容 */
+    SDL_RenderCopy(renderer, image.tex, &imgSrcRect, &imgPaintRect);
 
-        SDL_Color c{ 0, 0, 0, 128 };
-        SDL_Rect shadowPaintRect{ p.x - 1, p.y, mThumbSize + 2, mThumbSize + 2 };
+    SDL_Rect brect{ p.x + 1, p.y + 1, mThumbSize - 2, mThumbSize - 2};
+    brect = clip_rects(brect, clipRect);
+    if (brect.w > 0 && brect.h > 0)
+    {
+      SDL_SetRenderDrawColor(renderer, 0xff, 0xff, 0xff, 80);
+      SDL_RenderDrawRect(renderer, &brect);
+    }
+}
 
-        shadowPaintRect = clip_rects(shadowPaintRect, clipRect);
+void ImagePanel::draw(SDL_Renderer* renderer) 
+{
+    if (mLoader)
+    {
+        /* 每帧只创建少量纹理, 避免加载大目录时卡住界面 */
+        mLoader->upload(renderer, mUploadBatch);
+        /* 已经滚出可见范围的请求不再需要 */
+        mLoader->clearRequests();
+    }
+    mFrame++;
 
-        if (shadowPaintRect.w > 0 && shadowPaintRect.h > 0)
-        {
-          SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
-          SDL_RenderFillRect(renderer, &shadowPaintRect);
-        }
+  Vector2i grid = gridSize();
+    const ListImages& list = images();
 
-        SDL_Rect imgPaintRect{
-            (int)std::round(p.x + ix),
-            (int)std::round(p.y + iy),
-            (int)std::round(iw),
-            (int)std::round(ih)
-        };
-        SDL_Rect imgSrcRect{ 0, 0, imgw, imgh };
-        PntRect imgrect = clip_rects(srect2pntrect(imgPaintRect), clip);
-        imgPaintRect.w = imgrect.x2 - imgrect.x1;
-        imgPaintRect.h = imgrect.y2 - imgrect.y1;
-        if (imgPaintRect.y < clip.y1)
-        {
-          imgPaintRect.y = clip.y1;
-          imgSrcRect.h = (imgPaintRect.h / (float)ih) * imgh;
-          imgSrcRect.y = (1 - (imgPaintRect.h / (float)ih)) * imgh;
-        }
-        else if(imgPaintRect.h < ih)
-        {
-          imgSrcRect.h = (imgPaintRect.h / (float)ih) * imgh;
-        }
+    int ax = getAbsoluteLeft();
+    int ay = getAbsoluteTop();
+
+    PntRect clip = getAbsoluteCliprect();
+    SDL_Rect clipRect = pntrect2srect(clip);
 
-        /* 绘制图像内容 */
-        SDL_RenderCopy(renderer, mImages[i].tex, &imgSrcRect, &imgPaintRect);
+    /* 只遍历和裁剪区域相交的行列, 在 VScrollPanel 中图像很多时不会逐个计算 */
+    int stride = mThumbSize + mSpacing;
+    int firstRow = std::max(0, (clip.y1 - ay - mMargin) / stride);
+    int lastRow = std::min(grid.y - 1, (clip.y2 - ay - mMargin) / stride);
+    int firstCol = std::max(0, (clip.x1 - ax - mMargin) / stride);
+    int lastCol = std::min(grid.x - 1, (clip.x2 - ax - mMargin) / stride);
 
-        SDL_Rect brect{ p.x + 1, p.y + 1, mThumbSize - 2, mThumbSize - 2};
-        brect = clip_rects(brect, clipRect);
-        if (brect.w > 0 && brect.h > 0)
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+        for (int col = firstCol; col <= lastCol; ++col)
         {
-          SDL_SetRenderDrawColor(renderer, 0xff, 0xff, 0xff, 80);
-          SDL_RenderDrawRect(renderer, &brect);
+            size_t i = (size_t)(row * grid.x + col);
+            if (i >= list.size())
+                break;
+
+            if (mLoader)
+            {
+                if (list[i].tex)
+                    mLastSeen[i] = mFrame;
+                else
+                    mLoader->request((int)i);
+            }
+
+            Vector2i p = Vector2i(mMargin, mMargin) + Vector2i(col, row) * stride;
+            p += Vector2i(ax, ay);
+            drawImage(renderer, list[i], p, clip, clipRect);
         }
     }
 
+    evictImages();
+
     Widget::draw(renderer);
 }
 
@@ -13,6 +13,7 @@
 #pragma once
 
 #include <sdlgui/widget.h>
+#include <sdlgui/imageloader.h>
 
 NAMESPACE_BEGIN(sdlgui)
 
@@ -28,20 +29,45 @@ public:
     ImagePanel(Widget *parent, const ListImages &data)
       : ImagePanel(parent) { setImages(data); }
 
-    void setImages(const ListImages &data) { mImages = data; }
-    const ListImages& images() const { return mImages; }
+    void setImages(const ListImages &data) { mImages = data; mLoader = nullptr; invalidateLayout(); }
+    const ListImages& images() const { return mLoader ? mLoader->images() : mImages; }
+
+    /**
+     * Show the PNG images of \p path. Only thumbnails of the panel's thumb size are
+     * kept in video memory; they are decoded in the background when they scroll into
+     * view, at most \ref uploadBatch textures are created per frame, and the least
+     * recently seen ones are released beyond \ref maxResident.
+     */
+    void loadImageDirectory(const std::string &path, int threads = 0);
+
+    /// Maximum number of thumbnail textures kept when showing a directory
+    int maxResident() const { return mMaxResident; }
+    void setMaxResident(int count) { mMaxResident = std::max(1, count); }
+
+    /// Directory where generated thumbnails are cached between runs (empty disables the cache)
+    const std::string& thumbnailCache() const { return mThumbnailCache; }
+    void setThumbnailCache(const std::string &dir) { mThumbnailCache = dir; }
+    ImagePanel& withThumbnailCache(const std::string &dir) { setThumbnailCache(dir); return *this; }
+
+    int uploadBatch() const { return mUploadBatch; }
+    void setUploadBatch(int batch) { mUploadBatch = std::max(1, batch); }
 
     std::function<void(int)> callback() const { return mCallback; }
     void setCallback(const std::function<void(int)> &callback) { mCallback = callback; }
 
     bool mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) override;
+    bool mouseEnterEvent(const Vector2i &p, bool enter) override;
     bool mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers) override;
     Vector2i preferredSize(SDL_Renderer *ctx) const override;
     void draw(SDL_Renderer* renderer) override;
 
     ImagePanel& withImages(const ListImages& data ) { setImages(data); return *this; }
+    ImagePanel& withImageDirectory(const std::string &path) { loadImageDirectory(path); return *this; }
 protected:
   Vector2i gridSize() const;
+    void drawImage(SDL_Renderer* renderer, const ImageInfo& image, const Vector2i& p,
+                   const PntRect& clip, const SDL_Rect& clipRect);
+    void evictImages();
     int indexForPosition(const Vector2i &p) const;
 protected:
   ListImages mImages;
@@ -50,6 +76,13 @@ protected:
     int mSpacing;
     int mMargin;
     int mMouseIndex;
+    ref<ImageLoader> mLoader;
+    int mUploadBatch = 8;
+    std::string mThumbnailCache;
+    int mMaxResident = 512;
+    uint32_t mFrame = 0;
+    std::vector<uint32_t> mLastSeen;
+    std::vector<int> mResident;
 };
 
 NAMESPACE_END(sdlgui)
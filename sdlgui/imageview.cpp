@@ -19,7 +19,13 @@
 #include <SDL.h>
 #endif
 #include <sdlgui/theme.h>
+#include <sdlgui/stb_image.h>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 
 NAMESPACE_BEGIN(sdlgui)
 
@@ -40,6 +46,275 @@ namespace
     }
 }
 
+/* 金字塔瓦片: 工作线程加载像素, 绘制线程创建纹理并按 LRU 缓存 */
+struct ImageView::Tiles
+{
+    struct Decoded
+    {
+        uint64_t key;
+        Vector2i size;
+        std::vector<uint8_t> rgba;
+    };
+
+    struct Entry
+    {
+        SDL_Texture* tex;
+        Vector2i size;
+        uint32_t lastUsed;
+    };
+
+    Vector2i size;
+    int tileSize;
+    int levels;
+    TileLoader loader;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool cancel = false;
+    std::deque<uint64_t> requests;
+    std::unordered_set<uint64_t> pending;
+    std::deque<Decoded> ready;
+    std::vector<std::thread> threads;
+
+    std::unordered_map<uint64_t, Entry> cache;
+    uint32_t frame = 0;
+
+    static uint64_t key(int level, int x, int y)
+    {
+        return ((uint64_t)level << 48) | ((uint64_t)(uint32_t)y << 24) | (uint64_t)(uint32_t)x;
+    }
+
+    Tiles(const Vector2i& imageSize, const TileLoader& tileLoader, int tile)
+        : size(imageSize), tileSize(std::max(16, tile)), loader(tileLoader)
+    {
+        /* 最粗的一层只有一个瓦片 */
+        levels = 1;
+        while (std::max(size.x, size.y) > (tileSize << (levels - 1)))
+            levels++;
+
+        int count = std::max(1, std::min(4, (int)std::thread::hardware_concurrency() - 1));
+        for (int i = 0; i < count; i++)
+            threads.emplace_back(&Tiles::run, this);
+    }
+
+    ~Tiles()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            cancel = true;
+        }
+        cond.notify_all();
+        for (auto& t : threads)
+            t.join();
+        for (auto& it : cache)
+            SDL_DestroyTexture(it.second.tex);
+    }
+
+    void run()
+    {
+        while (true)
+        {
+            uint64_t k;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cond.wait(lock, [this] { return cancel || !requests.empty(); });
+                if (cancel)
+                    break;
+                k = requests.front();
+                requests.pop_front();
+            }
+
+            Decoded d;
+            d.key = k;
+            if (!loader((int)(k >> 48), (int)(k & 0xffffff), (int)((k >> 24) & 0xffffff), d.rgba, d.size)
+                || d.size.x <= 0 || d.size.y <= 0 || d.rgba.size() < (size_t)d.size.x * d.size.y * 4)
+            {
+                d.rgba.clear();
+            }
+
+            std::lock_guard<std::mutex> guard(mutex);
+            ready.push_back(std::move(d));
+        }
+    }
+
+    /* 最新的请求最先处理 */
+    void request(uint64_t k)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (pending.count(k))
+            return;
+        pending.insert(k);
+        requests.push_front(k);
+        cond.notify_one();
+    }
+
+    /* 丢弃还没有开始加载的请求, 它们可能已经移出可见范围 */
+    void clearRequests()
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        for (uint64_t k : requests)
+            pending.erase(k);
+        requests.clear();
+    }
+
+    void upload(SDL_Renderer* renderer, int maxTiles)
+    {
+        for (int i = 0; i < maxTiles; i++)
+        {
+            Decoded d;
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                if (ready.empty())
+                    break;
+                d = std::move(ready.front());
+                ready.pop_front();
+                /* 加载失败的瓦片不会再请求, 避免每帧重试 */
+                if (!d.rgba.empty())
+                    pending.erase(d.key);
+            }
+            if (d.rgba.empty() || cache.count(d.key))
+                continue;
+
+            SDL_Texture* tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, d.size.x, d.size.y);
+            if (!tex)
+                continue;
+            SDL_UpdateTexture(tex, nullptr, d.rgba.data(), d.size.x * 4);
+            SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+            cache[d.key] = Entry{ tex, d.size, frame };
+        }
+    }
+
+    Entry* find(int level, int x, int y)
+    {
+        auto it = cache.find(key(level, x, y));
+        if (it == cache.end())
+            return nullptr;
+        it->second.lastUsed = frame;
+        return &it->second;
+    }
+
+    /* 超出容量时释放最久没有使用的瓦片, 当前帧用到的保留 */
+    void evict(int capacity)
+    {
+        while ((int)cache.size() > capacity)
+        {
+            auto oldest = cache.end();
+            for (auto it = cache.begin(); it != cache.end(); ++it)
+                if (oldest == cache.end() || it->second.lastUsed < oldest->second.lastUsed)
+                    oldest = it;
+            if (oldest == cache.end() || oldest->second.lastUsed == frame)
+                break;
+            SDL_DestroyTexture(oldest->second.tex);
+            cache.erase(oldest);
+        }
+    }
+};
+
+void ImageView::setTiledImage(const Vector2i& size, const TileLoader& loader, int tileSize)
+{
+    mTexture = nullptr;
+    mTiles.reset(new Tiles(size, loader, tileSize));
+    mImageSize = size;
+    fit();
+}
+
+TileLoader ImageView::tileDirectory(const std::string& dir)
+{
+    return [dir](int level, int x, int y, std::vector<uint8_t>& rgba, Vector2i& size) {
+        char name[64];
+        snprintf(name, sizeof(name), "/%d/%d_%d.png", level, x, y);
+        int comp = 0;
+        stbi_uc* pixels = stbi_load((dir + name).c_str(), &size.x, &size.y, &comp, 4);
+        if (!pixels)
+            return false;
+        rgba.assign(pixels, pixels + (size_t)size.x * size.y * 4);
+        stbi_image_free(pixels);
+        return true;
+    };
+}
+
+/* 绘制可见的瓦片, 精细的瓦片还没有加载时用更粗一层的对应部分代替 */
+void ImageView::drawTiles(SDL_Renderer* renderer, const SDL_Point& ap)
+{
+    Tiles& tiles = *mTiles;
+    tiles.frame++;
+    tiles.upload(renderer, 8);
+    tiles.clearRequests();
+
+    /* 缩小显示时使用分辨率刚好够用的一层 */
+    int level = 0;
+    if (mScale < 1.f)
+        level = std::min(tiles.levels - 1, (int)std::floor(std::log2(1.f / mScale)));
+
+    Vector2f topLeft = clampedImageCoordinateAt(Vector2f::Zero());
+    Vector2f bottomRight = clampedImageCoordinateAt(sizeF());
+    int span = tiles.tileSize << level;
+    int tx0 = (int)topLeft.x / span, ty0 = (int)topLeft.y / span;
+    int tx1 = std::min(((int)std::ceil(bottomRight.x) - 1) / span, (mImageSize.x - 1) / span);
+    int ty1 = std::min(((int)std::ceil(bottomRight.y) - 1) / span, (mImageSize.y - 1) / span);
+
+    /* 同时受外层控件 (例如 VScrollPanel) 的裁剪区域限制, 结束时恢复原来的裁剪 */
+    SDL_Rect clip = clip_rects(SDL_Rect{ ap.x, ap.y, width(), height() }, pntrect2srect(getAbsoluteCliprect()));
+    RenderClipScope clipScope(renderer, clip);
+
+    /* 最粗的一层总是保留, 保证任何位置都有可以显示的内容 */
+    if (!tiles.find(tiles.levels - 1, 0, 0))
+        tiles.request(Tiles::key(tiles.levels - 1, 0, 0));
+
+    Vector2f apf(ap.x, ap.y);
+    for (int ty = ty0; ty <= ty1; ty++)
+    {
+        for (int tx = tx0; tx <= tx1; tx++)
+        {
+            /* 瓦片在原图中的范围 */
+            Vector2i i0(tx * span, ty * span);
+            Vector2i i1 = (i0 + Vector2i(span, span)).cmin(mImageSize);
+
+            int found = level;
+            Tiles::Entry* entry = tiles.find(level, tx, ty);
+            if (!entry)
+            {
+                tiles.request(Tiles::key(level, tx, ty));
+                for (found = level + 1; found < tiles.levels; found++)
+                {
+                    int parentSpan = tiles.tileSize << found;
+                    if ((entry = tiles.find(found, i0.x / parentSpan, i0.y / parentSpan)))
+                        break;
+                }
+            }
+            if (!entry)
+                continue;
+
+            /* 在找到的瓦片中对应的像素范围 */
+            int foundSpan = tiles.tileSize << found;
+            Vector2i origin = Vector2i(i0.x / foundSpan, i0.y / foundSpan) * foundSpan;
+            SDL_Rect src{
+                (i0.x - origin.x) >> found,
+                (i0.y - origin.y) >> found,
+                std::max(1, (i1.x - i0.x) >> found),
+                std::max(1, (i1.y - i0.y) >> found)
+            };
+            src.w = std::min(src.w, entry->size.x - src.x);
+            src.h = std::min(src.h, entry->size.y - src.y);
+            if (src.w <= 0 || src.h <= 0)
+                continue;
+
+            /* 两边分别取整, 相邻瓦片之间不会有缝 */
+            Vector2f p0 = apf + positionForCoordinate(i0.tofloat());
+            Vector2f p1 = apf + positionForCoordinate(i1.tofloat());
+            SDL_Rect dst{
+                (int)std::round(p0.x),
+                (int)std::round(p0.y),
+                (int)std::round(p1.x) - (int)std::round(p0.x),
+                (int)std::round(p1.y) - (int)std::round(p0.y)
+            };
+            SDL_RenderCopy(renderer, entry->tex, &src, &dst);
+        }
+    }
+
+    tiles.evict(mTileCacheSize);
+}
+
 ImageView::ImageView(Widget* parent, SDL_Texture* texture)
     : Widget(parent), mTexture(texture), mScale(1.0f), mOffset(Vector2f::Zero()),
     mFixedScale(false), mFixedOffset(false), mPixelInfoCallback(nullptr) 
@@ -51,6 +326,7 @@ ImageView::~ImageView() {}
 
 void ImageView::bindImage(SDL_Texture* texture) 
 {
+    mTiles.reset();
     mTexture = texture;
     updateImageParameters();
     fit();
@@ -262,7 +538,7 @@ void ImageView::draw(SDL_Renderer* renderer)
 
     SDL_Point ap = getAbsolutePos();
 
-    const Screen* screen = dynamic_cast<const Screen*>(this->window()->parent());
+    const Screen* screen = fast_cast<const Screen>(this->window()->parent());
     assert(screen);
     Vector2f screenSize = screen->size().tofloat();
     Vector2f scaleFactor = imageSizeF().cquotient(screenSize) * mScale;
@@ -311,6 +587,10 @@ void ImageView::draw(SDL_Renderer* renderer)
       /* 绘制 image 信息 */
       SDL_RenderCopy(renderer, mTexture, &imgrect, &rect);
     }
+    else if (mTiles)
+    {
+      drawTiles(renderer, ap);
+    }
 
     drawWidgetBorder(renderer, ap);
     drawImageBorder(renderer, ap);
@@ -322,7 +602,7 @@ void ImageView::draw(SDL_Renderer* renderer)
 
 void ImageView::updateImageParameters() 
 {
-  int w, h;
+  int w = 0, h = 0;
   SDL_QueryTexture(mTexture, nullptr, nullptr, &w, &h);
   mImageSize = Vector2i(w, h);
 }
@@ -15,9 +15,18 @@
 
 #include <sdlgui/widget.h>
 #include <functional>
+#include <memory>
 
 NAMESPACE_BEGIN(sdlgui)
 
+/**
+ * Fill \p rgba with tile (\p x, \p y) of pyramid level \p level and set \p size to its
+ * dimensions. Level 0 is full resolution and every level halves the image; tiles are
+ * square except on the right and bottom edges. Called from worker threads; return
+ * false when the tile is not available.
+ */
+typedef std::function<bool(int level, int x, int y, std::vector<uint8_t>& rgba, Vector2i& size)> TileLoader;
+
 /**
  * \class ImageView imageview.h sdl_gui/imageview.h
  *
@@ -133,10 +142,39 @@ public:
 
     ImageView& withImage(SDL_Texture *texture) { bindImage(texture); return *this; }
 
+    /**
+     * Show an image of \p size pixels as a pyramid of \p tileSize tiles. Only the tiles
+     * covering the visible part at the current scale are loaded, by background workers
+     * calling \p loader; coarser tiles are shown while finer ones load.
+     */
+    void setTiledImage(const Vector2i& size, const TileLoader& loader, int tileSize = 256);
+    ImageView& withTiledImage(const Vector2i& size, const TileLoader& loader, int tileSize = 256)
+    { setTiledImage(size, loader, tileSize); return *this; }
+
+    /// Is a tiled image shown?
+    bool tiled() const { return mTiles.get() != nullptr; }
+
+    /// Maximum number of tile textures kept in memory
+    int tileCacheSize() const { return mTileCacheSize; }
+    void setTileCacheSize(int count) { mTileCacheSize = std::max(4, count); }
+
+    /// Tile loader reading pre-cut tiles from \p dir/<level>/<x>_<y>.png
+    static TileLoader tileDirectory(const std::string& dir);
+
+protected:
+    /// Replace the texture by one of the same size without changing zoom and pan
+    void swapTexture(SDL_Texture* texture) { mTexture = texture; }
+
 private:
     // Helper image methods.
     void updateImageParameters();
 
+    // Tiled image.
+    struct Tiles;
+    void drawTiles(SDL_Renderer* renderer, const SDL_Point& ap);
+    std::unique_ptr<Tiles> mTiles;
+    int mTileCacheSize = 256;
+
     // Helper drawing methods.
     void drawWidgetBorder(SDL_Renderer* ctx, const SDL_Point& ap) const;
     void drawImageBorder(SDL_Renderer* ctx, const SDL_Point& ap) const;
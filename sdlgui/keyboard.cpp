@@ -79,13 +79,15 @@ struct Keyboard::AsyncTexture
 
 Keyboard::Keyboard(Widget *parent, Window *parentWindow, KeyboardType type)
     : Window(parent, ""), mParentWindow(parentWindow), mKeyboardType(type),
-      mAnchorPos(Vector2i::Zero()), mAnchorHeight(30) /* 默认锚点位置，在 Y 轴向下 30 像素的位置 */
+      mAnchorPos(Vector2i::Zero()), mAnchorHeight(30), /* 默认锚点位置，在 Y 轴向下 30 像素的位置 */
+      mTextBox(nullptr)
 {
+  mKind |= KeyboardKind;
   if (type == KeyboardType::Number)
   {
     setLayout(new GridLayout(Orientation::Horizontal, 3, Alignment::Middle, 5, 5));
     wdg<Button>("1").setWidgetCallback([](Widget *widget) {
-        Keyboard *keyboard = dynamic_cast<Keyboard*>(widget);
+        Keyboard *keyboard = fast_cast<Keyboard>(widget);
         keyboard->mKeyboardValue.push_back('1');
         keyboard->getTextBox()->setValue(keyboard->mKeyboardValue);
         keyboard->getTextBox()->focusEvent(true);
@@ -132,7 +134,7 @@ Keyboard::Keyboard(Widget *parent, Window *parentWindow, KeyboardType type)
         });
     Button *button_del = new Button(this, "", ENTYPO_ICON_LEFT_THIN);
     button_del->setWidgetCallback([](Widget *widget){
-      Keyboard *keyboard = dynamic_cast<Keyboard*>(widget);
+      Keyboard *keyboard = fast_cast<Keyboard>(widget);
       if (keyboard->mKeyboardValue.length())
       {
         keyboard->mKeyboardValue.pop_back();
@@ -165,7 +167,7 @@ Keyboard::Keyboard(Widget *parent, Window *parentWindow, KeyboardType type)
     //layout->setColStretch(2, 1);
     this->setLayout(layout);
     this->wdg<Button>("1").setWidgetCallback([](Widget *widget) {
-        Keyboard *keyboard = dynamic_cast<Keyboard*>(widget);
+        Keyboard *keyboard = fast_cast<Keyboard>(widget);
         keyboard->mKeyboardValue.push_back('1');
         keyboard->getTextBox()->setValue(keyboard->mKeyboardValue);
         keyboard->getTextBox()->focusEvent(true);
@@ -213,7 +215,7 @@ Keyboard::Keyboard(Widget *parent, Window *parentWindow, KeyboardType type)
         });
     Button *button_del = new Button(this, "", ENTYPO_ICON_LEFT_THIN);
     button_del->setWidgetCallback([](Widget *widget){
-      Keyboard *keyboard = dynamic_cast<Keyboard*>(widget);
+      Keyboard *keyboard = fast_cast<Keyboard>(widget);
       if (keyboard->mKeyboardValue.length())
       {
         keyboard->mKeyboardValue.pop_back();
@@ -248,7 +250,7 @@ Keyboard::Keyboard(Widget *parent, Window *parentWindow, KeyboardType type)
     for (; i < 4; i++)
       for (j = 0; j < 3; j++)
       {
-        dynamic_cast<Button *>(mChildren[i*3+j])->setFixedSize(Vector2i(29, 30));
+        fast_cast<Button>(mChildren[i*3+j])->setFixedSize(Vector2i(29, 30));
         layout->setAnchor(mChildren[i*3+j], AdvancedGridLayout::Anchor(j, i, 1, 1, Alignment::Middle));
       }
     mChildren[i*3]->setFixedSize(Vector2i(34 + 29*2, 30));
@@ -313,6 +315,32 @@ void Keyboard::rendereBodyTexture(NVGcontext*& ctx, int& realw, int& realh, int
   nvgEndFrame(ctx);
 }
 
+void Keyboard::attach(TextBox *textBox)
+{
+    if (mTextBox != textBox)
+    {
+        mTextBox = textBox;
+        mKeyboardValue = textBox->value();
+    }
+
+    Window *parentWindow = textBox->window();
+    if (mParentWindow != parentWindow)
+    {
+        if (mParentWindow)
+            mParentWindow->removeChildKeyboard(this);
+        mParentWindow = parentWindow;
+        mParentWindow->addChildKeyboard(this);
+    }
+    setAnchorPos(textBox->keyboardAnchor());
+}
+
+void Keyboard::detach()
+{
+    mTextBox = nullptr;
+    mParentWindow = nullptr;
+    setVisible(false);
+}
+
 void Keyboard::performLayout(SDL_Renderer *ctx) 
 {
     if (mLayout || mChildren.size() != 1) 
@@ -323,13 +351,18 @@ void Keyboard::performLayout(SDL_Renderer *ctx)
     {
         mChildren[0]->setPosition(Vector2i::Zero());
         mChildren[0]->setSize(mSize);
-        mChildren[0]->performLayout(ctx);
+        mChildren[0]->updateLayout(ctx);
     }
 }
 
 /* 获取控件的相对位置 */
 void Keyboard::refreshRelativePlacement() 
 {
+    if (!mParentWindow)
+    {
+        mVisible = false;
+        return;
+    }
     mParentWindow->refreshRelativePlacement();
     mVisible &= mParentWindow->visibleRecursive();
 
@@ -339,8 +372,8 @@ void Keyboard::refreshRelativePlacement()
     Screen *screen = (Screen *)widget;
     Vector2i screenSize = screen->size();
 
-    _pos = mParentWindow->position() + mAnchorPos - Vector2i(0, mAnchorHeight);
-    _pos = Vector2i(_pos.x, std::min(_pos.y, screen->size().y - mSize.y));
+    Vector2i pos = mParentWindow->position() + mAnchorPos - Vector2i(0, mAnchorHeight);
+    setPosition(Vector2i(pos.x, std::min(pos.y, screen->size().y - mSize.y)));
 }
 
 void Keyboard::drawBodyTemp(SDL_Renderer* renderer)
@@ -402,7 +435,7 @@ void Keyboard::drawBody(SDL_Renderer* renderer)
 	  /* 第一次会走到这里 */
   {
     /* 创建一个指定 id 的 vector 对象 */
-    AsyncTexturePtr newtx = std::make_shared<AsyncTexture>(id);
+    AsyncTexturePtr newtx = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>(), id);
     /* 添加新创建的 AsyncTexturePtr 到向量尾部
      * 执行这个 load 函数,这个函数会执行一次
      * */
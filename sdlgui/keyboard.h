@@ -31,8 +31,8 @@ enum class KeyboardType {
  *
  * \brief Keyboard window for combo boxes, keyboard buttons, nested dialogs etc.
  *
- * Usually the Keyboard instance is constructed by another widget (e.g. \ref KeyboardButton)
- * and does not need to be created by hand.
+ * Usually the Keyboard instance is obtained from \ref Screen::keyboard, which keeps
+ * one per \ref KeyboardType and attaches it to the \ref TextBox being edited.
  */
 class  Keyboard : public Window 
 {
@@ -67,6 +67,13 @@ public:
     TextBox *getTextBox(void){return mTextBox;};
     void setTextBox(TextBox *textBox) {mTextBox = textBox;};
 
+    /// Bind the keyboard to \p textBox and anchor it next to the window of the text box
+    void attach(TextBox *textBox);
+    /// Unbind the keyboard from its text box and hide it
+    void detach();
+
+    KeyboardType keyboardType() const { return mKeyboardType; }
+
 protected:
     /// Internal helper function to maintain nested window position values
     virtual void refreshRelativePlacement();
@@ -86,4 +93,6 @@ protected:
     KeyboardType mKeyboardType;
 };
 
+template<> struct WidgetKindOf<Keyboard> { enum { value = Widget::KeyboardKind }; };
+
 NAMESPACE_END(sdlgui)
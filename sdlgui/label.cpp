@@ -17,6 +17,7 @@ NAMESPACE_BEGIN(sdlgui)
 Label::Label(Widget *parent, const std::string &caption, const std::string &font, int fontSize)
     : Widget(parent), mCaption(caption), mFont(font) /* 关联到 parent widget */
 {
+    mKind |= LabelKind;
     if (mTheme) 
     {
         mFontSize = mTheme->mStandardFontSize;
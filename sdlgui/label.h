@@ -32,10 +32,10 @@ public:
     /// Get the label's text caption
     const std::string &caption() const { return mCaption; }
     /// Set the label's text caption
-    void setCaption(const std::string &caption) { mCaption = caption; _texture.dirty = true;}
+    void setCaption(const std::string &caption) { mCaption = caption; _texture.dirty = true; invalidateLayout(); }
 
     /// Set the currently active font (2 are available by default: 'sans' and 'sans-bold')
-    void setFont(const std::string &font) { mFont = font; }
+    void setFont(const std::string &font) { mFont = font; invalidateLayout(); }
     /// Get the currently active font
     const std::string &font() const { return mFont; }
 
@@ -61,4 +61,6 @@ protected:
     Texture _texture;
 };
 
+template<> struct WidgetKindOf<Label> { enum { value = Widget::LabelKind }; };
+
 NAMESPACE_END(sdlgui)
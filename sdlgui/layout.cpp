@@ -31,7 +31,7 @@ Vector2i BoxLayout::preferredSize(SDL_Renderer *ctx, const Widget *widget) const
   Vector2i size(2*mMargin, 2*mMargin);
 
     int yOffset = 0;
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = fast_cast<const Window>(widget);
     if (window && !window->title().empty()) 
     {
         if (mOrientation == Orientation::Vertical)
@@ -51,7 +51,7 @@ Vector2i BoxLayout::preferredSize(SDL_Renderer *ctx, const Widget *widget) const
         else
             size[axis1] += mSpacing;
 
-        Vector2i ps = w->preferredSize(ctx), fs = w->fixedSize();
+        Vector2i ps = w->measure(ctx), fs = w->fixedSize();
         Vector2i targetSize(
             fs[0] ? fs[0] : ps[0],
             fs[1] ? fs[1] : ps[1]
@@ -76,7 +76,7 @@ void BoxLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
     int _position = mMargin;
     int yOffset = 0;
 
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = fast_cast<const Window>(widget);
     if (window && !window->title().empty()) 
     {
         if (mOrientation == Orientation::Vertical) 
@@ -100,7 +100,7 @@ void BoxLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
         else
             _position += mSpacing;
 
-        Vector2i ps = w->preferredSize(ctx), fs = w->fixedSize();
+        Vector2i ps = w->measure(ctx), fs = w->fixedSize();
         Vector2i targetSize(
             fs.x ? fs.x : ps.x,
             fs.y ? fs.y : ps.y
@@ -128,7 +128,7 @@ void BoxLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
 
         w->setPosition(pos);
         w->setSize(targetSize);
-        w->performLayout(ctx);
+        w->updateLayout(ctx);
         _position += targetSize[axis1];
     }
 }
@@ -137,7 +137,7 @@ Vector2i GroupLayout::preferredSize(SDL_Renderer *ctx, const Widget *widget) con
 {
     int hh = mMargin, ww = 2*mMargin;
 
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = fast_cast<const Window>(widget);
     if (window && !window->title().empty())
         hh += widget->theme()->mWindowHeaderHeight - mMargin/2;
 
@@ -146,12 +146,12 @@ Vector2i GroupLayout::preferredSize(SDL_Renderer *ctx, const Widget *widget) con
     {
         if (!c->visible())
             continue;
-        const Label *label = dynamic_cast<const Label *>(c);
+        const Label *label = fast_cast<const Label>(c);
         if (!first)
             hh += (label == nullptr) ? mSpacing : mGroupSpacing;
         first = false;
 
-        Vector2i ps = c->preferredSize(ctx), fs = c->fixedSize();
+        Vector2i ps = c->measure(ctx), fs = c->fixedSize();
         Vector2i targetSize(
             fs.x ? fs.x : ps.x,
             fs.y ? fs.y : ps.y
@@ -173,7 +173,7 @@ void GroupLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
     int hh = mMargin, availableWidth =
         (widget->fixedWidth() ? widget->fixedWidth() : widget->width()) - 2*mMargin;
 
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = fast_cast<const Window>(widget);
     if (window && !window->title().empty())
         hh += widget->theme()->mWindowHeaderHeight - mMargin/2;
 
@@ -182,14 +182,14 @@ void GroupLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
     {
         if (!c->visible())
             continue;
-        const Label *label = dynamic_cast<const Label *>(c);
+        const Label *label = fast_cast<const Label>(c);
         if (!first)
             hh += (label == nullptr) ? mSpacing : mGroupSpacing;
         first = false;
 
         bool indentCur = indent && label == nullptr;
         Vector2i ps = Vector2i{ availableWidth - (indentCur ? mGroupIndent : 0),
-                               c->preferredSize(ctx).y };
+                               c->measure(ctx).y };
         Vector2i fs = c->fixedSize();
 
         Vector2i targetSize(
@@ -199,7 +199,7 @@ void GroupLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
 
         c->setPosition(Vector2i{ mMargin + (indentCur ? mGroupIndent : 0), hh });
         c->setSize(targetSize);
-        c->performLayout(ctx);
+        c->updateLayout(ctx);
 
         hh += targetSize.y;
 
@@ -222,7 +222,7 @@ Vector2i GridLayout::preferredSize(SDL_Renderer *ctx,
          + std::max((int) grid[1].size() - 1, 0) * mSpacing[1]
     );
 
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = fast_cast<const Window>(widget);
     if (window && !window->title().empty())
         size[1] += widget->theme()->mWindowHeaderHeight - mMargin/2;
 
@@ -256,7 +256,7 @@ void GridLayout::computeLayout(SDL_Renderer *ctx, const Widget *widget, std::vec
                 w = widget->children()[child++];
             } while (!w->visible());
 
-            Vector2i ps = w->preferredSize(ctx);
+            Vector2i ps = w->measure(ctx);
             Vector2i fs = w->fixedSize();
             Vector2i targetSize(
                 fs.x ? fs.x : ps.x,
@@ -285,7 +285,7 @@ void GridLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
     int dim[2] = { (int) grid[0].size(), (int) grid[1].size() };
 
     Vector2i extra = Vector2i::Zero();
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = fast_cast<const Window>(widget);
     if (window && !window->title().empty())
         extra[1] += widget->theme()->mWindowHeaderHeight - mMargin / 2;
 
@@ -337,8 +337,8 @@ void GridLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
                 w = widget->children()[child++];
             } while (!w->visible());
 
-            /* 执行 preferredSize() 函数,确定一个 preferredSize */
-            Vector2i ps = w->preferredSize(ctx);
+            /* 获取缓存的 preferredSize */
+            Vector2i ps = w->measure(ctx);
             /* 获取 fixed size */
             Vector2i fs = w->fixedSize();
             Vector2i targetSize(
@@ -373,7 +373,7 @@ void GridLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
             /* 确定了窗口的大小 */
             w->setSize(targetSize);
             /* 确定了窗口的布局 */
-            w->performLayout(ctx);
+            w->updateLayout(ctx);
             pos[axis1] += grid[axis1][i1] + mSpacing[axis1];
         }
         pos[axis2] += grid[axis2][i2] + mSpacing[axis2];
@@ -401,7 +401,7 @@ Vector2i AdvancedGridLayout::preferredSize(SDL_Renderer *ctx, const Widget *widg
         std::accumulate(grid[1].begin(), grid[1].end(), 0));
 
     Vector2i extra = Vector2i::Constant(2 * mMargin);
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = fast_cast<const Window>(widget);
     if (window && !window->title().empty())
         extra[1] += widget->theme()->mWindowHeaderHeight - mMargin/2;
 
@@ -416,7 +416,7 @@ void AdvancedGridLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
     computeLayout(ctx, widget, grid);
 
     grid[0].insert(grid[0].begin(), mMargin);
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = fast_cast<const Window>(widget);
     if (window && !window->title().empty())
         grid[1].insert(grid[1].begin(), widget->theme()->mWindowHeaderHeight + mMargin/2);
     else
@@ -436,7 +436,7 @@ void AdvancedGridLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
 
             int itemPos = grid[axis][anchor.pos[axis]];
             int cellSize  = grid[axis][anchor.pos[axis] + anchor.size[axis]] - itemPos;
-            int ps = w->preferredSize(ctx)[axis], fs = w->fixedSize()[axis];
+            int ps = w->measure(ctx)[axis], fs = w->fixedSize()[axis];
             int targetSize = fs ? fs : ps;
 
             switch (anchor.align[axis]) 
@@ -459,7 +459,7 @@ void AdvancedGridLayout::performLayout(SDL_Renderer *ctx, Widget *widget) const
             size[axis] = targetSize;
             w->setPosition(pos);
             w->setSize(size);
-            w->performLayout(ctx);
+            w->updateLayout(ctx);
         }
     }
 }
@@ -475,7 +475,7 @@ void AdvancedGridLayout::computeLayout(SDL_Renderer *ctx, const Widget *widget,
     );
 
     Vector2i extra(2 * mMargin, 2 * mMargin);
-    const Window *window = dynamic_cast<const Window *>(widget);
+    const Window *window = fast_cast<const Window>(widget);
     if (window && !window->title().empty())
         extra[1] += widget->theme()->mWindowHeaderHeight - mMargin/2;
 
@@ -499,7 +499,7 @@ void AdvancedGridLayout::computeLayout(SDL_Renderer *ctx, const Widget *widget,
                 if ((anchor.size[axis] == 1) != (phase == 0))
                     continue;
                 /* 计算这个窗口的宽和高 */
-                int ps = w->preferredSize(ctx)[axis], fs = w->fixedSize()[axis];
+                int ps = w->measure(ctx)[axis], fs = w->fixedSize()[axis];
                 int targetSize = fs ? fs : ps;
 
                 if (anchor.pos[axis] + anchor.size[axis] > (int) grid.size())
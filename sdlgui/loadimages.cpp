@@ -1,4 +1,5 @@
 #include <sdlgui/common.h>
+#include <sdlgui/imageloader.h>
 
 #if defined(_WIN32)
 #include <SDL.h>
@@ -9,6 +10,7 @@
 #include <windows.h>
 #else
 #include <dirent.h>
+#include <sys/stat.h>
 #endif
 
 #if defined(_WIN32)
@@ -17,11 +19,21 @@
 #include <SDL_image.h>
 #endif
 
+#include <sdlgui/stb_image.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
 NAMESPACE_BEGIN(sdlgui)
 
-ListImages loadImageDirectory(SDL_Renderer* renderer, const std::string &path) 
+/* 列出目录下所有的 png 文件 */
+static std::vector<std::string> listImageFiles(const std::string &path)
 {
-  ListImages result;
+  std::vector<std::string> result;
 #if !defined(_WIN32)
     DIR *dp = opendir(path.c_str());
     if (!dp)
@@ -40,7 +52,22 @@ ListImages loadImageDirectory(SDL_Renderer* renderer, const std::string &path)
 #endif
         if (strstr(fname, "png") == nullptr)
             continue;
-        std::string fullName = path + "/" + std::string(fname);
+        result.push_back(path + "/" + std::string(fname));
+#if !defined(_WIN32)
+    }
+    closedir(dp);
+#else
+    } while (FindNextFileA(handle, &ffd) != 0);
+    FindClose(handle);
+#endif
+    return result;
+}
+
+ListImages loadImageDirectory(SDL_Renderer* renderer, const std::string &path) 
+{
+  ListImages result;
+    for (auto& fullName : listImageFiles(path))
+    {
         SDL_Texture* tex = IMG_LoadTexture(renderer, fullName.c_str());
         if (tex == 0)
             throw std::runtime_error("Could not open image data!");
@@ -51,14 +78,371 @@ ListImages loadImageDirectory(SDL_Renderer* renderer, const std::string &path)
         
         /* 尾部插入这个元素 */
         result.push_back(iminfo);
-#if !defined(_WIN32)
     }
-    closedir(dp);
+    return result;
+}
+
+/* 文件内容的 FNV-1a 哈希, 作为缩略图缓存的文件名 */
+static bool hashFile(const std::string &path, uint64_t &hash)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    hash = 14695981039346656037ULL;
+    unsigned char buf[16384];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        for (size_t i = 0; i < n; i++)
+            hash = (hash ^ buf[i]) * 1099511628211ULL;
+    fclose(f);
+    return true;
+}
+
+static void makeDirectory(const std::string &path)
+{
+#if !defined(_WIN32)
+    mkdir(path.c_str(), 0755);
 #else
-    } while (FindNextFileA(handle, &ffd) != 0);
-    FindClose(handle);
+    CreateDirectoryA(path.c_str(), NULL);
 #endif
-    return result;
+}
+
+/* 缩略图缓存文件: 4 字节标识, 宽, 高, 然后是 RGBA 像素 */
+static const char thumbMagic[4] = { 'S', 'G', 'T', '1' };
+
+static stbi_uc* readThumbnail(const std::string &path, int &w, int &h)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+        return nullptr;
+    char magic[4];
+    int32_t size[2];
+    stbi_uc *pixels = nullptr;
+    if (fread(magic, 1, 4, f) == 4 && memcmp(magic, thumbMagic, 4) == 0
+        && fread(size, sizeof(int32_t), 2, f) == 2 && size[0] > 0 && size[1] > 0
+        && size[0] <= 4096 && size[1] <= 4096)
+    {
+        size_t bytes = (size_t)size[0] * size[1] * 4;
+        /* stbi_image_free 默认就是 free, 和 stbi_load 的结果一样释放 */
+        pixels = (stbi_uc*)malloc(bytes);
+        if (pixels && fread(pixels, 1, bytes, f) == bytes)
+        {
+            w = size[0];
+            h = size[1];
+        }
+        else
+        {
+            stbi_image_free(pixels);
+            pixels = nullptr;
+        }
+    }
+    fclose(f);
+    return pixels;
+}
+
+static void writeThumbnail(const std::string &path, const stbi_uc *pixels, int w, int h)
+{
+    /* 先写临时文件再改名, 其他进程不会读到写了一半的缓存 */
+    std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f)
+        return;
+    int32_t size[2] = { w, h };
+    bool ok = fwrite(thumbMagic, 1, 4, f) == 4 && fwrite(size, sizeof(int32_t), 2, f) == 2
+              && fwrite(pixels, 1, (size_t)w * h * 4, f) == (size_t)w * h * 4;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+        remove(tmp.c_str());
+}
+
+/*
+ * 盒式滤波缩小 RGBA 图像: 每个输出像素是它覆盖的源像素的平均值.
+ * 先水平后垂直两遍, 内层循环是连续的整数累加, 编译器可以向量化.
+ */
+static stbi_uc* boxDownscale(const stbi_uc *src, int w, int h, int dw, int dh)
+{
+    std::vector<uint32_t> row((size_t)dw * 4);
+    std::vector<uint32_t> acc((size_t)dw * 4);
+    std::vector<int> x0(dw + 1);
+    for (int x = 0; x <= dw; x++)
+        x0[x] = (int)((int64_t)x * w / dw);
+
+    stbi_uc *dst = (stbi_uc*)malloc((size_t)dw * dh * 4);
+    if (!dst)
+        return nullptr;
+
+    for (int y = 0; y < dh; y++)
+    {
+        int y0 = (int)((int64_t)y * h / dh);
+        int y1 = std::max(y0 + 1, (int)((int64_t)(y + 1) * h / dh));
+        std::fill(acc.begin(), acc.end(), 0);
+        for (int sy = y0; sy < y1; sy++)
+        {
+            const stbi_uc *line = src + (size_t)sy * w * 4;
+            for (int x = 0; x < dw; x++)
+            {
+                int xb = x0[x], xe = std::max(xb + 1, x0[x + 1]);
+                uint32_t r = 0, g = 0, b = 0, a = 0;
+                for (int sx = xb; sx < xe; sx++)
+                {
+                    r += line[sx * 4 + 0];
+                    g += line[sx * 4 + 1];
+                    b += line[sx * 4 + 2];
+                    a += line[sx * 4 + 3];
+                }
+                row[x * 4 + 0] = r; row[x * 4 + 1] = g;
+                row[x * 4 + 2] = b; row[x * 4 + 3] = a;
+            }
+            for (size_t i = 0; i < acc.size(); i++)
+                acc[i] += row[i];
+        }
+
+        stbi_uc *out = dst + (size_t)y * dw * 4;
+        for (int x = 0; x < dw; x++)
+        {
+            uint32_t n = (uint32_t)(std::max(x0[x] + 1, x0[x + 1]) - x0[x]) * (y1 - y0);
+            for (int c = 0; c < 4; c++)
+                out[x * 4 + c] = (stbi_uc)((acc[x * 4 + c] + n / 2) / n);
+        }
+    }
+    return dst;
+}
+
+/* 工作线程解码, 解码好的像素放在队列里等待绘制线程创建纹理 */
+struct ImageLoader::Workers
+{
+    struct Decoded
+    {
+        int index;
+        int w, h;
+        stbi_uc* pixels;
+    };
+
+    std::vector<std::string> files;
+    int thumbSize = 0;
+    std::string cacheDir;
+    bool onDemand = false;
+    bool cancel = false;
+
+    /* requests, queued 和 failed 由 mutex 保护, queued 标记已经请求但还没有创建纹理的图像 */
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<int> requests;
+    std::vector<uint8_t> queued;
+    std::vector<uint8_t> failed; /* 解码失败的图像, 不再重复请求 */
+    std::deque<Decoded> ready;
+    std::vector<std::thread> threads;
+    /* 只在 upload 里访问: 按需加载时释放的图像会被再次上传, 同一张图像只计数一次 */
+    std::vector<uint8_t> handledOnce;
+    int handled = 0;
+
+    void run()
+    {
+        while (true)
+        {
+            int index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cond.wait(lock, [this] { return cancel || !requests.empty(); });
+                if (cancel)
+                    break;
+                index = requests.front();
+                requests.pop_front();
+            }
+
+            Decoded d{ index, 0, 0, nullptr };
+            load(files[index], d);
+
+            std::lock_guard<std::mutex> guard(mutex);
+            ready.push_back(d);
+        }
+    }
+
+    void load(const std::string &file, Decoded &d)
+    {
+        std::string cached;
+        if (thumbSize > 0 && !cacheDir.empty())
+        {
+            uint64_t hash;
+            if (hashFile(file, hash))
+            {
+                char name[64];
+                snprintf(name, sizeof(name), "/%016llx_%d.thumb", (unsigned long long)hash, thumbSize);
+                cached = cacheDir + name;
+                if ((d.pixels = readThumbnail(cached, d.w, d.h)))
+                    return;
+            }
+        }
+
+        int comp = 0;
+        d.pixels = stbi_load(file.c_str(), &d.w, &d.h, &comp, 4);
+        if (!d.pixels)
+        {
+            printf("Could not decode image %s\n", file.c_str());
+            return;
+        }
+        if (thumbSize <= 0)
+            return;
+
+        /* 短边缩小到 thumbSize, ImagePanel 按短边填满方格 */
+        int shortSide = std::min(d.w, d.h);
+        if (shortSide > thumbSize)
+        {
+            int dw = std::max(1, (int)((int64_t)d.w * thumbSize / shortSide));
+            int dh = std::max(1, (int)((int64_t)d.h * thumbSize / shortSide));
+            if (stbi_uc *thumb = boxDownscale(d.pixels, d.w, d.h, dw, dh))
+            {
+                stbi_image_free(d.pixels);
+                d.pixels = thumb;
+                d.w = dw;
+                d.h = dh;
+            }
+        }
+        if (!cached.empty())
+            writeThumbnail(cached, d.pixels, d.w, d.h);
+    }
+
+    ~Workers()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            cancel = true;
+        }
+        cond.notify_all();
+        for (auto& t : threads)
+            t.join();
+        for (auto& d : ready)
+            stbi_image_free(d.pixels);
+    }
+};
+
+ImageLoader::ImageLoader(const std::string &path, int threads, int thumbSize,
+                         const std::string &cacheDir, bool onDemand)
+    : mWorkers(new Workers)
+{
+    mWorkers->files = listImageFiles(path);
+    mWorkers->thumbSize = thumbSize;
+    mWorkers->cacheDir = cacheDir;
+    mWorkers->onDemand = onDemand;
+    if (thumbSize > 0 && !cacheDir.empty())
+        makeDirectory(cacheDir);
+    mImages.resize(mWorkers->files.size());
+    for (size_t i = 0; i < mImages.size(); i++)
+    {
+        mImages[i].path = mWorkers->files[i];
+        mImages[i].w = mImages[i].h = 0;
+    }
+
+    /* 不是按需加载时一开始就请求所有的图像 */
+    mWorkers->queued.assign(mImages.size(), onDemand ? 0 : 1);
+    mWorkers->failed.assign(mImages.size(), 0);
+    mWorkers->handledOnce.assign(mImages.size(), 0);
+    if (!onDemand)
+        for (size_t i = 0; i < mImages.size(); i++)
+            mWorkers->requests.push_back((int)i);
+
+    if (threads <= 0)
+        threads = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    threads = std::min(threads, std::max(1, (int)mImages.size()));
+    for (int i = 0; i < threads; i++)
+        mWorkers->threads.emplace_back(&Workers::run, mWorkers.get());
+}
+
+ImageLoader::~ImageLoader()
+{
+    /* 按需加载时纹理属于 loader, 否则交给调用者 */
+    if (mWorkers->onDemand)
+        for (auto& info : mImages)
+            if (info.tex)
+                SDL_DestroyTexture(info.tex);
+}
+
+int ImageLoader::total() const
+{
+    return (int)mImages.size();
+}
+
+int ImageLoader::loaded() const
+{
+    return mWorkers->handled;
+}
+
+void ImageLoader::request(int index)
+{
+    if (index < 0 || index >= total() || mImages[index].tex)
+        return;
+
+    std::lock_guard<std::mutex> guard(mWorkers->mutex);
+    if (mWorkers->queued[index] || mWorkers->failed[index])
+        return;
+    /* 最新的请求最先处理, 快速滚动时优先加载当前看到的图像 */
+    mWorkers->queued[index] = 1;
+    mWorkers->requests.push_front(index);
+    mWorkers->cond.notify_one();
+}
+
+void ImageLoader::clearRequests()
+{
+    std::lock_guard<std::mutex> guard(mWorkers->mutex);
+    for (int index : mWorkers->requests)
+        mWorkers->queued[index] = 0;
+    mWorkers->requests.clear();
+}
+
+void ImageLoader::release(int index)
+{
+    if (index < 0 || index >= total() || !mImages[index].tex)
+        return;
+    SDL_DestroyTexture(mImages[index].tex);
+    mImages[index].tex = nullptr;
+}
+
+int ImageLoader::upload(SDL_Renderer *renderer, int maxImages)
+{
+    int count = 0;
+    while (count < maxImages)
+    {
+        Workers::Decoded d;
+        {
+            std::lock_guard<std::mutex> guard(mWorkers->mutex);
+            if (mWorkers->ready.empty())
+                break;
+            d = mWorkers->ready.front();
+            mWorkers->ready.pop_front();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(mWorkers->mutex);
+            mWorkers->queued[d.index] = 0;
+            if (!d.pixels)
+                mWorkers->failed[d.index] = 1;
+        }
+
+        ImageInfo& info = mImages[d.index];
+        if (d.pixels && !info.tex)
+        {
+            /* stb_image 输出的是按字节排列的 RGBA */
+            info.tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, d.w, d.h);
+            if (info.tex)
+            {
+                SDL_UpdateTexture(info.tex, nullptr, d.pixels, d.w * 4);
+                SDL_SetTextureBlendMode(info.tex, SDL_BLENDMODE_BLEND);
+                info.w = d.w;
+                info.h = d.h;
+            }
+        }
+        stbi_image_free(d.pixels);
+
+        if (!mWorkers->handledOnce[d.index])
+        {
+            mWorkers->handledOnce[d.index] = 1;
+            mWorkers->handled++;
+        }
+        count++;
+        if (info.tex && mCallback)
+            mCallback(d.index, info);
+    }
+    return count;
 }
 
 NAMESPACE_END(sdlgui)
@@ -0,0 +1,316 @@
+/*
+    sdlgui/pool.cpp -- Small object pool used by Object and PoolAllocator
+
+    Based on NanoGUI by Wenzel Jakob <wenzel@inf.ethz.ch>.
+    Adaptation for SDL by Dalerank <dalerankn8@gmail.com>
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <sdlgui/common.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <cstddef>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+NAMESPACE_BEGIN(sdlgui)
+
+namespace
+{
+    /* 16 字节一档, 超过 kMaxSmall 的直接从堆上分配 */
+    const size_t kGranule = 16;
+    const size_t kMaxSmall = 1024;
+    const size_t kClasses = kMaxSmall / kGranule;
+    /* chunk 按自身大小对齐, 块的地址去掉低位就是所在的 chunk */
+    const size_t kChunkSize = 64 * 1024;
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    struct Pool;
+
+    struct Chunk
+    {
+        Pool *owner;
+        Chunk *next;
+        size_t cls;
+        size_t used; /* 只由拥有者线程修改 */
+        /* 对齐到 kGranule, 块从头部之后开始 */
+        alignas(16) char blocks[1];
+    };
+
+    const size_t kHeader = offsetof(Chunk, blocks);
+
+    /* 每个线程一个池: 拥有者线程不加锁地分配和释放, 其他线程释放的块放进 remoteFree,
+       由拥有者在分配或 trim 时收回. 线程退出后池被挂起, 由下一个新线程接管 */
+    struct Pool
+    {
+        FreeBlock *freeLists[kClasses] = {};
+        Chunk *chunks = nullptr;
+        std::atomic<FreeBlock *> remoteFree{nullptr};
+
+        /* 计数只由拥有者写入, poolStats 从别的线程读取 */
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> frees{0};
+        std::atomic<size_t> chunkCount{0};
+
+        Pool *nextPool = nullptr;      /* 所有池, 由 registryMutex 保护 */
+        Pool *nextAbandoned = nullptr; /* 没有线程拥有的池, 由 registryMutex 保护 */
+    };
+
+    /* 不析构: 静态对象析构后仍可能有 Object 被释放 */
+    std::mutex &registryMutex()
+    {
+        static std::mutex *m = new std::mutex();
+        return *m;
+    }
+    Pool *allPools = nullptr;
+    Pool *abandonedPools = nullptr;
+
+    void bump(std::atomic<size_t> &counter, ptrdiff_t delta)
+    {
+        /* 只有一个写者, 不需要原子的读改写 */
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    size_t classOf(size_t size) { return (std::max<size_t>(size, 1) + kGranule - 1) / kGranule - 1; }
+    size_t blockSize(size_t cls) { return (cls + 1) * kGranule; }
+    size_t blocksPerChunk(size_t cls) { return (kChunkSize - kHeader) / blockSize(cls); }
+    Chunk *chunkOf(const void *block) { return (Chunk *) ((uintptr_t) block & ~(uintptr_t) (kChunkSize - 1)); }
+
+    void *allocChunk()
+    {
+#if defined(_WIN32)
+        void *p = _aligned_malloc(kChunkSize, kChunkSize);
+#else
+        void *p = nullptr;
+        if (posix_memalign(&p, kChunkSize, kChunkSize) != 0)
+            p = nullptr;
+#endif
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    void freeChunk(Chunk *chunk)
+    {
+#if defined(_WIN32)
+        _aligned_free(chunk);
+#else
+        free(chunk);
+#endif
+    }
+
+    void addChunk(Pool &p, size_t cls)
+    {
+        Chunk *chunk = (Chunk *) allocChunk();
+        chunk->owner = &p;
+        chunk->cls = cls;
+        chunk->used = 0;
+        chunk->next = p.chunks;
+        p.chunks = chunk;
+        bump(p.chunkCount, 1);
+
+        size_t bs = blockSize(cls), count = blocksPerChunk(cls);
+        for (size_t i = count; i-- > 0;)
+        {
+            FreeBlock *block = (FreeBlock *) (chunk->blocks + i * bs);
+            block->next = p.freeLists[cls];
+            p.freeLists[cls] = block;
+        }
+    }
+
+    /* 拥有者收回其他线程释放的块 */
+    void drainRemote(Pool &p)
+    {
+        FreeBlock *block = p.remoteFree.exchange(nullptr, std::memory_order_acquire);
+        while (block)
+        {
+            FreeBlock *next = block->next;
+            Chunk *chunk = chunkOf(block);
+            block->next = p.freeLists[chunk->cls];
+            p.freeLists[chunk->cls] = block;
+            chunk->used--;
+            block = next;
+        }
+    }
+
+    /* 把没有已用块的 chunk 还给堆; 调用者必须是拥有者, 或者持有 registryMutex 且池没有拥有者 */
+    size_t trimPool(Pool &p)
+    {
+        drainRemote(p);
+
+        size_t released = 0;
+        for (Chunk *chunk = p.chunks; chunk; chunk = chunk->next)
+            released += chunk->used == 0 ? 1 : 0;
+        if (!released)
+            return 0;
+
+        /* 从空闲链表中去掉要释放的 chunk 的块 */
+        for (size_t cls = 0; cls < kClasses; cls++)
+        {
+            FreeBlock **link = &p.freeLists[cls];
+            while (*link)
+            {
+                if (chunkOf(*link)->used == 0)
+                    *link = (*link)->next;
+                else
+                    link = &(*link)->next;
+            }
+        }
+
+        Chunk **link = &p.chunks;
+        while (*link)
+        {
+            Chunk *chunk = *link;
+            if (chunk->used == 0)
+            {
+                *link = chunk->next;
+                freeChunk(chunk);
+                bump(p.chunkCount, -1);
+            }
+            else
+                link = &chunk->next;
+        }
+        return released;
+    }
+
+    Pool *adoptPool()
+    {
+        std::lock_guard<std::mutex> guard(registryMutex());
+        if (Pool *p = abandonedPools)
+        {
+            abandonedPools = p->nextAbandoned;
+            p->nextAbandoned = nullptr;
+            return p;
+        }
+        Pool *p = new Pool();
+        p->nextPool = allPools;
+        allPools = p;
+        return p;
+    }
+
+    void abandonPool(Pool *p)
+    {
+        std::lock_guard<std::mutex> guard(registryMutex());
+        trimPool(*p);
+        p->nextAbandoned = abandonedPools;
+        abandonedPools = p;
+    }
+
+    /* tlsPool 是平凡类型, 线程局部对象析构之后仍然可以访问 */
+    thread_local Pool *tlsPool = nullptr;
+    thread_local bool tlsExited = false;
+
+    struct PoolOwner
+    {
+        ~PoolOwner()
+        {
+            tlsExited = true;
+            if (tlsPool)
+                abandonPool(tlsPool);
+            tlsPool = nullptr;
+        }
+    };
+    thread_local PoolOwner tlsOwner;
+
+    Pool &localPool()
+    {
+        if (!tlsPool)
+        {
+            tlsPool = adoptPool();
+            /* 线程退出后才分配的池不再挂起, 进程结束时一起回收 */
+            if (!tlsExited)
+                (void) &tlsOwner;
+        }
+        return *tlsPool;
+    }
+}
+
+void *poolAllocate(size_t size)
+{
+    if (size > kMaxSmall)
+        return ::operator new(size);
+
+    Pool &p = localPool();
+    size_t cls = classOf(size);
+    if (!p.freeLists[cls])
+    {
+        drainRemote(p);
+        if (!p.freeLists[cls])
+            addChunk(p, cls);
+    }
+    FreeBlock *block = p.freeLists[cls];
+    p.freeLists[cls] = block->next;
+    chunkOf(block)->used++;
+    bump(p.allocations, 1);
+    return block;
+}
+
+void poolFree(void *ptr, size_t size) noexcept
+{
+    if (!ptr)
+        return;
+    if (size > kMaxSmall)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+
+    Pool &local = localPool();
+    bump(local.frees, 1);
+    FreeBlock *block = (FreeBlock *) ptr;
+    Chunk *chunk = chunkOf(block);
+    Pool *owner = chunk->owner;
+    if (owner == &local)
+    {
+        block->next = local.freeLists[chunk->cls];
+        local.freeLists[chunk->cls] = block;
+        chunk->used--;
+        return;
+    }
+
+    /* 别的线程的块: 无锁地压到拥有者的 remoteFree 上, 只有拥有者整体取走, 没有 ABA 问题 */
+    FreeBlock *head = owner->remoteFree.load(std::memory_order_relaxed);
+    do
+        block->next = head;
+    while (!owner->remoteFree.compare_exchange_weak(head, block, std::memory_order_release,
+                                                     std::memory_order_relaxed));
+}
+
+size_t poolTrim()
+{
+    size_t released = trimPool(localPool());
+
+    std::lock_guard<std::mutex> guard(registryMutex());
+    for (Pool *p = abandonedPools; p; p = p->nextAbandoned)
+        released += trimPool(*p);
+    return released;
+}
+
+PoolStats poolStats()
+{
+    PoolStats stats;
+    std::lock_guard<std::mutex> guard(registryMutex());
+    for (Pool *p = allPools; p; p = p->nextPool)
+    {
+        stats.allocations += p->allocations.load(std::memory_order_relaxed);
+        stats.frees += p->frees.load(std::memory_order_relaxed);
+        stats.chunks += p->chunkCount.load(std::memory_order_relaxed);
+    }
+    /* 块可能在一个线程分配, 在另一个线程释放, 只有总数有意义 */
+    stats.live = stats.allocations > stats.frees ? stats.allocations - stats.frees : 0;
+    stats.bytes = stats.chunks * kChunkSize;
+    return stats;
+}
+
+NAMESPACE_END(sdlgui)
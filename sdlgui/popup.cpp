@@ -71,6 +71,16 @@ Popup::Popup(Widget *parent, Window *parentWindow)
     : Window(parent, ""), mParentWindow(parentWindow),
       mAnchorPos(Vector2i::Zero()), mAnchorHeight(30)
 {
+  mKind |= PopupKind;
+  /* 挂到父窗口的层上, 父窗口置顶时一起置顶 */
+  if (mParentWindow)
+    mParentWindow->attachPopup(this);
+}
+
+Popup::~Popup()
+{
+  if (mParentWindow)
+    mParentWindow->detachPopup(this);
 }
 
 void Popup::rendereBodyTexture(NVGcontext*& ctx, int& realw, int& realh, int dx)
@@ -130,12 +140,17 @@ void Popup::performLayout(SDL_Renderer *ctx)
     {
         mChildren[0]->setPosition(Vector2i::Zero());
         mChildren[0]->setSize(mSize);
-        mChildren[0]->performLayout(ctx);
+        mChildren[0]->updateLayout(ctx);
     }
 }
 
 void Popup::refreshRelativePlacement() 
 {
+    if (!mParentWindow)
+    {
+        mVisible = false;
+        return;
+    }
     mParentWindow->refreshRelativePlacement();
     mVisible &= mParentWindow->visibleRecursive();
 
@@ -145,8 +160,8 @@ void Popup::refreshRelativePlacement()
     Screen *screen = (Screen *)widget;
     Vector2i screenSize = screen->size();
 
-    _pos = mParentWindow->position() + mAnchorPos - Vector2i(0, mAnchorHeight);
-    _pos = Vector2i(_pos.x, std::min(_pos.y, screen->size().y - mSize.y));
+    Vector2i pos = mParentWindow->position() + mAnchorPos - Vector2i(0, mAnchorHeight);
+    setPosition(Vector2i(pos.x, std::min(pos.y, screen->size().y - mSize.y)));
 }
 
 void Popup::drawBodyTemp(SDL_Renderer* renderer)
@@ -201,7 +216,7 @@ void Popup::drawBody(SDL_Renderer* renderer)
   }
   else
   {
-    AsyncTexturePtr newtx = std::make_shared<AsyncTexture>(id);
+    AsyncTexturePtr newtx = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>(), id);
     newtx->load(this, _anchorDx);
     _txs.push_back(newtx);
   }
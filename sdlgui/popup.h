@@ -28,6 +28,7 @@ NAMESPACE_BEGIN(sdlgui)
  */
 class  Popup : public Window 
 {
+    friend class Window;
 public:
     /// Create a new popup parented to a screen (first argument) and a parent window
     Popup(Widget *parent, Window *parentWindow);
@@ -56,6 +57,7 @@ public:
     virtual void drawBodyTemp(SDL_Renderer* renderer);
 
 protected:
+    virtual ~Popup();
     /// Internal helper function to maintain nested window position values
     virtual void refreshRelativePlacement();
     virtual void rendereBodyTexture(NVGcontext* &ctx, int& ctxw, int& ctxh, int dx);
@@ -71,4 +73,6 @@ protected:
     std::vector<AsyncTexturePtr> _txs;
 };
 
+template<> struct WidgetKindOf<Popup> { enum { value = Widget::PopupKind }; };
+
 NAMESPACE_END(sdlgui)
@@ -148,7 +148,7 @@ void ProgressBar::drawBody(SDL_Renderer* renderer)
 {
   if (!_body)
   {
-    _body = std::make_shared<AsyncTexture>();
+    _body = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>());
     _body->load_body(this);
   }
 
@@ -163,7 +163,7 @@ void ProgressBar::drawBody(SDL_Renderer* renderer)
 void ProgressBar::drawBar(SDL_Renderer* renderer)
 {
   if (!_bar)
-    _bar = std::make_shared<AsyncTexture>();
+    _bar = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>());
 
   if (mValue != _bar->value)
     _bar->load_bar(this, _bar->value);
@@ -30,11 +30,23 @@ NAMESPACE_BEGIN(sdlgui)
 
 std::map<SDL_Window *, Screen *> __sdlgui_screens;
 
+/* post() 队列的节点, 第一个节点是不带任务的哨兵 */
+struct Screen::Task
+{
+    std::atomic<Task *> next{ nullptr };
+    std::function<void()> func;
+    Uint64 posted = 0;
+};
+
 Screen::Screen( SDL_Window* window, const Vector2i &size, const std::string &caption,
                bool resizable, bool fullscreen)
     : Widget(nullptr), _window(nullptr), mSDL_Renderer(nullptr), mCaption(caption)
       /* 初始化一个 Widget 对象？？？ */
 {
+    mScreen = this;
+    mKind |= ScreenKind;
+    mTaskTail = new Task;
+    mTaskHead.store(mTaskTail);
     SDL_SetWindowTitle( window, caption.c_str() );
     initialize( window );
 }
@@ -47,12 +59,20 @@ bool Screen::onEvent(SDL_Event& event)
     if (it == __sdlgui_screens.end())
        return false;
 
+    /* post() 发来的唤醒事件, 任务在 drawAll 中执行 */
+    if (event.type == mWakeEvent)
+        return true;
+
+    ++mEventCount;
+
     switch( event.type )
     {
     case SDL_MOUSEWHEEL:
     {
         if (!mProcessEvents)
             return false;
+        flushMotion();
+        ++mDispatchCount;
         return scrollCallbackEvent(event.wheel.x, event.wheel.y);
     }
     break;
@@ -61,8 +81,12 @@ bool Screen::onEvent(SDL_Event& event)
     {
       if (!mProcessEvents)
          return false;
-      /* 首先会更新鼠标的位置信息 */
-      return cursorPosCallbackEvent(event.motion.x, event.motion.y);
+      /* 触摸屏模拟出来的鼠标事件由下面的 SDL_FINGER* 处理 */
+      if (event.motion.which == SDL_TOUCH_MOUSEID)
+        return false;
+      /* 只记录最新位置, 在 drawAll 或下一个按键/滚轮/键盘事件之前统一分发 */
+      queueMotion(Vector2i(event.motion.x, event.motion.y));
+      return true;
     }
     break;
 
@@ -72,18 +96,57 @@ bool Screen::onEvent(SDL_Event& event)
     {
       if (!mProcessEvents)
         return false;
+      if (event.button.which == SDL_TOUCH_MOUSEID)
+        return false;
 
+      flushMotion();
+      ++mDispatchCount;
       SDL_Keymod mods = SDL_GetModState();
       /* 按键的回调函数 */
       return mouseButtonCallbackEvent(event.button.button, event.button.type, mods);
     }
     break;
 
+    /* 触摸屏: 只跟踪第一个按下的手指, 当作左键处理, 坐标是 0~1 的归一化值 */
+    case SDL_FINGERDOWN:
+    case SDL_FINGERMOTION:
+    case SDL_FINGERUP:
+    {
+      if (!mProcessEvents)
+        return false;
+
+      const SDL_TouchFingerEvent &finger = event.tfinger;
+      Vector2i p((int) (finger.x * mSize.x), (int) (finger.y * mSize.y));
+      if (event.type == SDL_FINGERDOWN)
+      {
+        if (mTouchActive)
+          return false;
+        mTouchActive = true;
+        mTouchFinger = finger.fingerId;
+        queueMotion(p);
+        flushMotion();
+        ++mDispatchCount;
+        return mouseButtonCallbackEvent(SDL_BUTTON_LEFT, SDL_MOUSEBUTTONDOWN, SDL_GetModState());
+      }
+      if (!mTouchActive || finger.fingerId != mTouchFinger)
+        return false;
+      queueMotion(p);
+      if (event.type == SDL_FINGERMOTION)
+        return true;
+      mTouchActive = false;
+      flushMotion();
+      ++mDispatchCount;
+      return mouseButtonCallbackEvent(SDL_BUTTON_LEFT, SDL_MOUSEBUTTONUP, SDL_GetModState());
+    }
+    break;
+
     case SDL_KEYDOWN:
     case SDL_KEYUP:
     {
       if (!mProcessEvents)
         return false;
+      flushMotion();
+      ++mDispatchCount;
 
       SDL_Keymod mods = SDL_GetModState();
       /* 键盘按键的回调函数 */
@@ -95,6 +158,8 @@ bool Screen::onEvent(SDL_Event& event)
     {
       if (!mProcessEvents)
         return false;
+      flushMotion();
+      ++mDispatchCount;
       return charCallbackEvent(event.text.text[0]);
     }
     break;
@@ -102,6 +167,24 @@ bool Screen::onEvent(SDL_Event& event)
     return false;
 }
 
+void Screen::queueMotion(const Vector2i &p)
+{
+    if (mMotionPending)
+        ++mCoalescedCount;
+    mMotionPending = true;
+    mPendingMotion = p;
+}
+
+/* 合并后的 motion 只分发一次, 相对位移是相对上次分发时的 mMousePos, 自然就是累计值 */
+bool Screen::flushMotion()
+{
+    if (!mMotionPending)
+        return false;
+    mMotionPending = false;
+    ++mDispatchCount;
+    return cursorPosCallbackEvent(mPendingMotion.x, mPendingMotion.y);
+}
+
 void Screen::initialize(SDL_Window* window)
 {
     _window = window;    
@@ -120,6 +203,7 @@ void Screen::initialize(SDL_Window* window)
     mDragActive = false;
     mLastInteraction = SDL_GetTicks();
     mProcessEvents = true;
+    mWakeEvent = SDL_RegisterEvents(1);
     mBackground = Color(0.3f, 0.3f, 0.32f, 1.0f);
     __sdlgui_screens[_window] = this;
 }
@@ -127,6 +211,72 @@ void Screen::initialize(SDL_Window* window)
 Screen::~Screen()
 {
     __sdlgui_screens.erase(_window);
+    /* 丢弃没有执行的任务 */
+    while (Task *next = mTaskTail->next.load(std::memory_order_acquire))
+    {
+        delete mTaskTail;
+        mTaskTail = next;
+    }
+    delete mTaskTail;
+}
+
+/* 多生产者单消费者的无锁队列: 生产者只交换 mTaskHead, 只有主线程移动 mTaskTail */
+void Screen::post(const std::function<void()> &func)
+{
+    Task *task = new Task;
+    task->func = func;
+    task->posted = SDL_GetPerformanceCounter();
+
+    mTaskDepth.fetch_add(1);
+    Task *prev = mTaskHead.exchange(task, std::memory_order_acq_rel);
+    prev->next.store(task, std::memory_order_release);
+
+    /* 每次清空队列后只发一个唤醒事件, 让阻塞在 SDL_WaitEvent 的主循环醒来 */
+    if (!mWakePending.exchange(true))
+        wakeEventLoop();
+}
+
+void Screen::wakeEventLoop()
+{
+    if (mWakeEvent == (Uint32) -1)
+        return;
+    SDL_Event event;
+    memset(&event, 0, sizeof(event));
+    event.type = mWakeEvent;
+    SDL_PushEvent(&event);
+}
+
+void Screen::processTasks()
+{
+    mWakePending.store(false);
+
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    int count = 0;
+    while (Task *next = mTaskTail->next.load(std::memory_order_acquire))
+    {
+        /* next 成为新的哨兵, 先把任务取出来 */
+        std::function<void()> func = std::move(next->func);
+        float latency = (start - std::min(start, next->posted)) * 1000.f / freq;
+        delete mTaskTail;
+        mTaskTail = next;
+        mTaskDepth.fetch_sub(1);
+
+        mTaskLatency = mTaskLatency > 0.f ? mTaskLatency * 0.9f + latency * 0.1f : latency;
+        ++count;
+        if (func)
+            func();
+
+        /* 超过预算时剩下的留到下一帧, 并且保证主循环会被再次唤醒 */
+        float elapsed = (SDL_GetPerformanceCounter() - start) * 1000.f / freq;
+        if (elapsed >= mTaskBudget && mTaskTail->next.load(std::memory_order_acquire))
+        {
+            if (!mWakePending.exchange(true))
+                wakeEventLoop();
+            break;
+        }
+    }
+    mTasksRun = count;
 }
 
 void Screen::setVisible(bool visible)
@@ -160,6 +310,24 @@ void Screen::setSize(const Vector2i &size)
 /* 窗口绘制 */
 void Screen::drawAll()
 {
+  /* 记录两帧之间的时间, 用来判断界面是否跟不上 frameBudget */
+  Uint64 now = SDL_GetPerformanceCounter();
+  if (mFrameStart)
+  {
+    float interval = (now - mFrameStart) * 1000.f / SDL_GetPerformanceFrequency();
+    /* 窗口隐藏等原因造成的长时间停顿不计入 */
+    if (interval < 1000.f)
+      mFrameTime = mFrameTime > 0.f ? mFrameTime * 0.9f + interval * 0.1f : interval;
+  }
+  mFrameStart = now;
+
+  flushMotion();
+  processTasks();
+  mEventsReceived = mEventCount;
+  mEventsDispatched = mDispatchCount;
+  mMotionCoalesced = mCoalescedCount;
+  mEventCount = mDispatchCount = mCoalescedCount = 0;
+
   drawContents(); /* 虚函数动态链编 */
   drawWidgets(); 
 }
@@ -177,7 +345,10 @@ void Screen::drawWidgets()
     
     SDL_Renderer* renderer = SDL_GetRenderer(_window);
     /* 遍历执行 child 的 draw 函数,这个是重点 */
+    mDrawnCount = mCulledCount = 0;
     draw(renderer);
+    mWidgetsDrawn = mDrawnCount;
+    mWidgetsCulled = mCulledCount;
 
     double elapsed = SDL_GetTicks() - mLastInteraction;
     if (elapsed > 0.5f) 
@@ -247,15 +418,8 @@ bool Screen::cursorPosCallbackEvent(double x, double y)
     {
         p -= Vector2i(1, 2);
 
-        if (!mDragActive) 
-        {
-            Widget *widget = findWidget(p);
-            /*if (widget != nullptr && widget->cursor() != mCursor) {
-                mCursor = widget->cursor();
-                glfwSetCursor(mGLFWWindow, mCursors[(int) mCursor]);
-            }*/
-        } 
-        else 
+        /* 鼠标下的控件由 updateHover 查找, 这里只处理拖动 */
+        if (mDragActive) 
         {
             ret = mDragWidget->mouseDragEvent(
                 p - mDragWidget->parent()->absolutePosition(), p - mMousePos,
@@ -263,7 +427,10 @@ bool Screen::cursorPosCallbackEvent(double x, double y)
         }
 
         if (!ret)
+        {
+            updateHover(p);
             ret = mouseMotionEvent(p, p - mMousePos, mMouseState, mModifiers);
+        }
 
         /* 在这里更新了鼠标的位置信息么 */
         mMousePos = p;
@@ -288,7 +455,7 @@ bool Screen::mouseButtonCallbackEvent(int button, int action, int modifiers) {
              * 这里为什么要减去 2 ？？？
              * */
             const Window *window =
-                dynamic_cast<Window *>(mFocusPath[mFocusPath.size() - 2]);
+                fast_cast<Window>(mFocusPath[mFocusPath.size() - 2]);
             if (window && window->modal()) {
                 /* 确认这个 window 是否包含这个触发点，如果不包含直接返回
                  * 如果包含 contains 函数返回 1
@@ -310,7 +477,7 @@ bool Screen::mouseButtonCallbackEvent(int button, int action, int modifiers) {
 
         /* 查找触发的 widget */
         auto dropWidget = findWidget(mMousePos);
-        if (isModal && (!dropWidget->window()->modal() && !dynamic_cast<Keyboard *>(dropWidget)))
+        if (isModal && (!dropWidget->window()->modal() && !fast_cast<Keyboard>(dropWidget)))
         {
             return false;
         }
@@ -402,7 +569,7 @@ bool Screen::scrollCallbackEvent(double x, double y)
     try {
         if (mFocusPath.size() > 1) {
             const Window *window =
-                dynamic_cast<Window *>(mFocusPath[mFocusPath.size() - 2]);
+                fast_cast<Window>(mFocusPath[mFocusPath.size() - 2]);
             if (window && window->modal()) {
                 if (!window->contains(mMousePos))
                     return false;
@@ -428,7 +595,7 @@ bool Screen::resizeCallbackEvent(int, int)
         return false;
 
     mFBSize = fbSize;
-    mSize = size;
+    Widget::setSize(size);
     mLastInteraction = SDL_GetTicks();
 
     try 
@@ -456,7 +623,7 @@ void Screen::updateFocus(Widget *widget) {
     while (widget) {
         /* 更新 focus 向量,重新插入元素 */
         mFocusPath.push_back(widget);
-        if (dynamic_cast<Window *>(widget))
+        if (fast_cast<Window>(widget))
             window = widget;
         widget = widget->parent();
     }
@@ -472,58 +639,222 @@ void Screen::updateFocus(Widget *widget) {
     }
 }
 
+void Screen::updateHover(const Vector2i &p)
+{
+    std::vector<Widget *> &path = mHoverScratch;
+    path.clear();
+    for (Widget *w = findWidget(p); w && w != this; w = w->parent())
+        path.push_back(w);
+    std::reverse(path.begin(), path.end());
+
+    size_t common = 0;
+    while (common < path.size() && common < mHoverPath.size() && path[common] == mHoverPath[common])
+        ++common;
+
+    /* 先从里到外离开旧路径, 再从外到里进入新路径 */
+    for (size_t i = mHoverPath.size(); i-- > common;)
+        mHoverPath[i]->mouseEnterEvent(p - mHoverPath[i]->parent()->absolutePosition(), false);
+    for (size_t i = common; i < path.size(); ++i)
+        path[i]->mouseEnterEvent(p - path[i]->parent()->absolutePosition(), true);
+
+    mHoverPath.swap(path);
+}
+
+void Screen::dropHoverPath(const Widget *widget)
+{
+    auto it = std::find(mHoverPath.begin(), mHoverPath.end(), widget);
+    if (it != mHoverPath.end())
+        mHoverPath.erase(it, mHoverPath.end());
+}
+
 void Screen::disposeWindow(Window *window) {
     if (std::find(mFocusPath.begin(), mFocusPath.end(), window) != mFocusPath.end())
         mFocusPath.clear();
     if (mDragWidget == window)
         mDragWidget = nullptr;
     removeChild(window);
+    /* 窗口的控件已经还给对象池, 把完全空闲的 chunk 一起还给堆 */
+    poolTrim();
 }
 
 void Screen::centerWindow(Window *window) 
 {
   if (window->size() == Vector2i{0, 0}) 
   {
-     window->setSize(window->preferredSize(mSDL_Renderer));
+     window->setSize(window->measure(mSDL_Renderer));
      window->performLayout(mSDL_Renderer);
   }
   /* 设置居中位置 */
   window->setPosition((mSize - window->size()) / 2);
 }
 
+void Screen::collectWindowLayer(Window *window, std::vector<Window *> &layer) const
+{
+    if (window->parent() == this)
+        layer.push_back(window);
+    for (auto popup : window->mPopups)
+        collectWindowLayer(popup, layer);
+}
+
+/* 窗口和挂在它上面的 popup 组成一层, 置顶时整层按先序 splice 到 mZOrder 的最后,
+ * 开销是 O(这一层的窗口数), 和 Screen 上其他子控件的数量无关 */
 void Screen::moveWindowToFront(Window *window) {
-    /* 删除所有的 mChildren 节点 */
-    mChildren.erase(std::remove(mChildren.begin(), mChildren.end(), window), mChildren.end());
-    /* 这里重新修改了 window 的队列么？？？ */
-    mChildren.push_back(window);
-    /* Brute force topological sort (no problem for a few windows..) */
-    bool changed = false;
-    do {
-        size_t baseIndex = 0;
-        for (size_t index = 0; index < mChildren.size(); ++index)
-            if (mChildren[index] == window)
-                baseIndex = index;
-        changed = false;
-        for (size_t index = 0; index < mChildren.size(); ++index) {
-            Popup *pw = dynamic_cast<Popup *>(mChildren[index]);
-            if (pw && pw->parentWindow() == window && index < baseIndex) {
-                moveWindowToFront(pw);
-                changed = true;
-                break;
-            }
+    Popup *popup = fast_cast<Popup>(window);
+    if (popup && popup->parentWindow())
+        popup->parentWindow()->raisePopup(popup);
+
+    std::vector<Window *> layer;
+    collectWindowLayer(window, layer);
+    for (auto w : layer)
+    {
+        auto it = mZPos.find(w);
+        if (it != mZPos.end())
+            mZOrder.splice(mZOrder.end(), mZOrder, it->second);
+    }
+}
+
+/* 新的子控件放在 mChildren 中下一个子控件的下面, 追加时就是最上面 */
+void Screen::addChild(int index, Widget *widget)
+{
+    Widget::addChild(index, widget);
+    auto below = mZOrder.end();
+    if (index + 1 < childCount())
+    {
+        auto it = mZPos.find(mChildren[index + 1]);
+        if (it != mZPos.end())
+            below = it->second;
+    }
+    mZPos[widget] = mZOrder.insert(below, widget);
+}
+
+void Screen::dropZOrder(const Widget *widget)
+{
+    auto it = mZPos.find(widget);
+    if (it == mZPos.end())
+        return;
+    mZOrder.erase(it->second);
+    mZPos.erase(it);
+}
+
+/* 下面几个和 Widget 的版本相同, 只是按 mZOrder 的顺序遍历子控件.
+ * 事件处理中置顶窗口或者添加子控件不会使 std::list 的迭代器失效 */
+Widget *Screen::findWidget(const Vector2i &p)
+{
+    for (auto it = mZOrder.rbegin(); it != mZOrder.rend(); ++it)
+    {
+        Widget *child = *it;
+        if (child->visible() && child->contains(p - _pos))
+            return child->findWidget(p - _pos);
+    }
+    return contains(p) ? this : nullptr;
+}
+
+bool Screen::mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers)
+{
+    for (auto it = mZOrder.rbegin(); it != mZOrder.rend(); ++it)
+    {
+        Widget *child = *it;
+        if (child->visible() && child->contains(p - _pos) &&
+            child->mouseButtonEvent(p - _pos, button, down, modifiers))
+            return true;
+    }
+
+    if (button == SDL_BUTTON_LEFT && down && !mFocused)
+        requestFocus();
+    return false;
+}
+
+bool Screen::mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers)
+{
+    for (auto it = mZOrder.rbegin(); it != mZOrder.rend(); ++it)
+    {
+        Widget *child = *it;
+        if (child->visible() && child->contains(p - _pos))
+            return child->mouseMotionEvent(p - _pos, rel, button, modifiers);
+    }
+    return false;
+}
+
+bool Screen::scrollEvent(const Vector2i &p, const Vector2f &rel)
+{
+    for (auto it = mZOrder.rbegin(); it != mZOrder.rend(); ++it)
+    {
+        Widget *child = *it;
+        if (child->visible() && child->contains(p - _pos) && child->scrollEvent(p - _pos, rel))
+            return true;
+    }
+    return false;
+}
+
+void Screen::draw(SDL_Renderer *renderer)
+{
+    PntRect clip = getAbsoluteCliprect();
+    for (auto child : mZOrder)
+        drawChild(renderer, child, clip);
+}
+
+Keyboard *Screen::keyboard(KeyboardType type)
+{
+    Keyboard *&keyboard = mKeyboards[(int) type];
+    if (!keyboard)
+    {
+        keyboard = new Keyboard(this, nullptr, type);
+        keyboard->setVisible(false);
+        keyboard->setSize(keyboard->measure(mSDL_Renderer));
+        keyboard->performLayout(mSDL_Renderer);
+    }
+    return keyboard;
+}
+
+void Screen::indexId(const std::string &id, Widget *widget)
+{
+    mIdIndex.emplace(id, widget);
+    mIdGeneration++;
+}
+
+void Screen::unindexId(const std::string &id, Widget *widget)
+{
+    auto range = mIdIndex.equal_range(id);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == widget)
+        {
+            mIdIndex.erase(it);
+            break;
         }
-    } while (changed);
+    }
+    mIdGeneration++;
+}
+
+Widget *Screen::findId(const std::string &id, const Widget *within) const
+{
+    if (id == mId)
+        return const_cast<Screen *>(this);
+
+    auto range = mIdIndex.equal_range(id);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (!within || within == this)
+            return it->second;
+        /* 只返回 within 子树中的控件 */
+        for (const Widget *w = it->second; w; w = w->parent())
+            if (w == within)
+                return it->second;
+    }
+    return nullptr;
 }
 
 void Screen::performLayout(SDL_Renderer* ctx)
 {
-    /* 确定布局函数 */
+    /* 确定布局函数, 只有被标记或尺寸变化的子树会重新计算 */
+  Widget::resetMeasureCount();
   Widget::performLayout(ctx);
+  mLayoutDirty = false;
 }
 
 void Screen::performLayout()
 {
-  Widget::performLayout(mSDL_Renderer);
+  performLayout(mSDL_Renderer);
 }
 
 NAMESPACE_END(sdlgui)
@@ -14,12 +14,19 @@
 #define __SDLGUI_SCREEN_H__
 
 #include <sdlgui/window.h>
+#include <unordered_map>
+#include <list>
+#include <cstdint>
 
 union SDL_Event;
 struct SDL_Window;
 
 NAMESPACE_BEGIN(sdlgui)
 
+template<typename T> class WidgetHandle;
+class Keyboard;
+enum class KeyboardType;
+
 /**
  * \brief Represents a display surface (i.e. a full-screen or windowed GLFW window)
  * and forms the root element of a hierarchy of sdlgui widgets
@@ -58,6 +65,12 @@ public:
     /// Return the ratio between pixel and device coordinates (e.g. >= 2 on Mac Retina displays)
     float pixelRatio() const { return mPixelRatio; }
 
+    /**
+     * \brief Handle an SDL event.
+     *
+     * Mouse and touch motion is only recorded here; the latest position is dispatched once,
+     * by \ref drawAll or before the next button, wheel or key event.
+     */
     virtual bool onEvent(SDL_Event& event);
 
     /// Draw the window contents -- put your OpenGL draw calls here
@@ -77,6 +90,17 @@ public:
 
     virtual void drawAll();
 
+    /// Target time between two frames in milliseconds
+    float frameBudget() const { return mFrameBudget; }
+    /// Set the target time between two frames in milliseconds, used to detect when drawing falls behind
+    void setFrameBudget(float budget) { mFrameBudget = budget > 0.f ? budget : 0.f; }
+
+    /// Smoothed time between the last frames drawn by \ref drawAll, in milliseconds
+    float frameTime() const { return mFrameTime; }
+
+    /// Ratio between \ref frameTime and \ref frameBudget; above 1 the UI misses its budget
+    float frameLoad() const { return mFrameBudget > 0.f ? mFrameTime / mFrameBudget : 0.f; }
+
     /// Return the last observed mouse position value
     Vector2i mousePos() const { return mMousePos; }
 
@@ -86,9 +110,67 @@ public:
     /// Return a pointer to the underlying nanoVG draw context
     SDL_Renderer *sdlRenderer() { return mSDL_Renderer; }
 
-    /// Compute the layout of all widgets
+    /// Compute the layout of the widgets whose layout is outdated (see \ref Widget::invalidateLayout)
     void performLayout();
 
+    /// Number of preferred sizes computed by the last \ref performLayout
+    int measureCount() const { return Widget::measureCount(); }
+
+    /// Return the on-screen keyboard of \p type, created on first use and shared by all the text boxes
+    Keyboard *keyboard(KeyboardType type);
+
+    /// Allocation counters of the pool that widgets, layouts and widget textures are allocated from
+    PoolStats poolStats() const { return sdlgui::poolStats(); }
+
+    /// Give the fully free chunks of the pool back to the heap, e.g. after closing many windows;
+    /// \ref disposeWindow already does this. Returns the number of chunks released
+    size_t trimPool() { return sdlgui::poolTrim(); }
+
+    /**
+     * \brief Queue \p func to run on the thread that calls \ref drawAll; may be called from any thread.
+     *
+     * The queue is drained at the start of \ref drawAll, before the widgets are drawn, for at most
+     * \ref taskBudget milliseconds per frame. Posting also pushes an SDL event so that a main loop
+     * blocked in SDL_WaitEvent wakes up.
+     */
+    void post(const std::function<void()> &func);
+
+    /// Maximum time in milliseconds spent running posted tasks per frame; at least one task always runs
+    float taskBudget() const { return mTaskBudget; }
+    /// Set the maximum time in milliseconds spent running posted tasks per frame
+    void setTaskBudget(float budget) { mTaskBudget = budget > 0.f ? budget : 0.f; }
+
+    /// Number of posted tasks that have not run yet
+    int taskQueueDepth() const { return mTaskDepth.load(); }
+    /// Smoothed time between \ref post and the start of the drain that ran the task, in milliseconds
+    float taskLatency() const { return mTaskLatency; }
+    /// Number of posted tasks run during the last frame
+    int tasksRun() const { return mTasksRun; }
+
+    /// Number of SDL events passed to \ref onEvent between the last two frames
+    int eventsReceived() const { return mEventsReceived; }
+    /// Number of events dispatched to the widgets between the last two frames, after coalescing
+    int eventsDispatched() const { return mEventsDispatched; }
+    /// Number of mouse/touch motion events merged into a later one between the last two frames
+    int motionCoalesced() const { return mMotionCoalesced; }
+
+    /// Number of widgets drawn during the last frame
+    int widgetsDrawn() const { return mWidgetsDrawn; }
+    /// Number of widgets skipped during the last frame because they were outside the clip rectangle of their parent
+    int widgetsCulled() const { return mWidgetsCulled; }
+
+    /// Direct children from bottom to top; \ref children keeps the order they were added in
+    const std::list<Widget *> &zOrder() const { return mZOrder; }
+
+    /* Screen 的子控件按 mZOrder 的顺序绘制和接收事件 */
+    using Widget::addChild;
+    void addChild(int index, Widget *widget) override;
+    Widget *findWidget(const Vector2i &p) override;
+    bool mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers) override;
+    bool mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) override;
+    bool scrollEvent(const Vector2i &p, const Vector2f &rel) override;
+    void draw(SDL_Renderer *renderer) override;
+
     /* window 类模板 返回一个 Window 的引用 */
     template<typename... Args>Window& window(const Args&... args) { return wdg<Window>(args...); }
 public:
@@ -110,6 +192,31 @@ public:
     void centerWindow(Window *window);
     void moveWindowToFront(Window *window);
     void drawWidgets();
+    /* 鼠标/触摸移动只保留最新位置, flushMotion 时分发一次 */
+    void queueMotion(const Vector2i &p);
+    bool flushMotion();
+    /* 在 drawAll 中执行 post() 队列里的任务 */
+    void processTasks();
+    void wakeEventLoop();
+    /* 重新计算鼠标所在的路径, 只给变化的节点发送 enter/leave */
+    void updateHover(const Vector2i &p);
+    /* widget 从树上移除时, 把它和它下面的节点从 hover 路径中去掉 */
+    void dropHoverPath(const Widget *widget);
+    /* 子控件从 Screen 上移除时, 由 Widget::removeChild 调用 */
+    void dropZOrder(const Widget *widget);
+    /* 收集 window 和挂在它上面的 popup (先序), 只收集 Screen 的直接子控件 */
+    void collectWindowLayer(Window *window, std::vector<Window *> &layer) const;
+
+    /* ID 索引, 由 Widget::setId/addChild/removeChild 维护 */
+    void indexId(const std::string &id, Widget *widget);
+    void unindexId(const std::string &id, Widget *widget);
+    /// Return a widget with ID \p id, inside the subtree of \p within if given
+    Widget *findId(const std::string &id, const Widget *within = nullptr) const;
+    /// Incremented whenever the ID index changes, see \ref WidgetHandle
+    uint64_t idGeneration() const { return mIdGeneration; }
+
+    /// Return a handle to the widget with ID \p id which caches the lookup
+    template<typename T> WidgetHandle<T> handle(const std::string &id) { return WidgetHandle<T>(this, id); }
 
     void performLayout(SDL_Renderer *renderer);
 
@@ -118,6 +225,13 @@ protected:
     /* mFocusPath 是 Widgets 指针的 **向量类型**
      * */
     std::vector<Widget *> mFocusPath;
+    /* 鼠标所在的控件路径, 从 Screen 的子控件开始, 不包括 Screen 本身 */
+    std::vector<Widget *> mHoverPath;
+    std::vector<Widget *> mHoverScratch;
+    /* 子控件的 z-order, 从下到上. mZPos 记录每个子控件在 mZOrder 中的位置,
+     * 置顶一层窗口时只 splice 这一层的节点, 不扫描其他子控件 */
+    std::list<Widget *> mZOrder;
+    std::unordered_map<const Widget *, std::list<Widget *>::iterator> mZPos;
     SDL_Renderer* mSDL_Renderer;
     Vector2i mFBSize;
     float mPixelRatio;
@@ -131,6 +245,70 @@ protected:
     std::string mCaption;
     std::string _lastTooltip;
     Texture _tooltipTex;
+    float mFrameBudget = 1000.f / 30.f;
+    float mFrameTime = 0.f;
+    Uint64 mFrameStart = 0;
+    /* Widget::draw 累加, 每帧结束时保存 */
+    int mDrawnCount = 0, mCulledCount = 0;
+    int mWidgetsDrawn = 0, mWidgetsCulled = 0;
+    bool mMotionPending = false;
+    Vector2i mPendingMotion;
+    bool mTouchActive = false;
+    SDL_FingerID mTouchFinger = 0;
+    /* onEvent 累加, drawAll 时保存 */
+    int mEventCount = 0, mDispatchCount = 0, mCoalescedCount = 0;
+    int mEventsReceived = 0, mEventsDispatched = 0, mMotionCoalesced = 0;
+    struct Task;
+    std::atomic<Task *> mTaskHead{ nullptr };
+    Task *mTaskTail = nullptr;
+    std::atomic<int> mTaskDepth{ 0 };
+    std::atomic<bool> mWakePending{ false };
+    Uint32 mWakeEvent = (Uint32) -1;
+    float mTaskBudget = 4.f;
+    float mTaskLatency = 0.f;
+    int mTasksRun = 0;
+    Keyboard *mKeyboards[3] = {};
+    std::unordered_multimap<std::string, Widget *> mIdIndex;
+    uint64_t mIdGeneration = 0;
+};
+
+template<> struct WidgetKindOf<Screen> { enum { value = Widget::ScreenKind }; };
+
+/**
+ * \brief Typed reference to a widget by ID.
+ *
+ * The pointer is cached and looked up again only after the ID index of the
+ * screen changed, so a removed widget is never returned.
+ */
+template<typename T>
+class WidgetHandle
+{
+public:
+    WidgetHandle() {}
+    WidgetHandle(Screen *screen, const std::string &id) : mScreen(screen), mId(id) {}
+
+    const std::string &id() const { return mId; }
+
+    T *get() const
+    {
+        if (!mScreen)
+            return nullptr;
+        if (mGeneration != mScreen->idGeneration())
+        {
+            mWidget = fast_cast<T>(mScreen->findId(mId));
+            mGeneration = mScreen->idGeneration();
+        }
+        return mWidget;
+    }
+
+    T *operator->() const { return get(); }
+    explicit operator bool() const { return get() != nullptr; }
+
+private:
+    Screen *mScreen = nullptr;
+    std::string mId;
+    mutable T *mWidget = nullptr;
+    mutable uint64_t mGeneration = ~uint64_t(0);
 };
 
 NAMESPACE_END(sdlgui)
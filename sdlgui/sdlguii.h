@@ -28,9 +28,12 @@
 #include <sdl_gui/messagedialog.h>
 #include <sdl_gui/textbox.h>
 #include <sdl_gui/slider.h>
+#include <sdl_gui/imageloader.h>
 #include <sdl_gui/imagepanel.h>
 #include <sdl_gui/imageview.h>
+#include <sdl_gui/streamimageview.h>
 #include <sdl_gui/vscrollpanel.h>
 #include <sdl_gui/colorwheel.h>
 #include <sdl_gui/graph.h>
+#include <sdl_gui/sparklinebank.h>
 #include <sdl_gui/formhelper.h>
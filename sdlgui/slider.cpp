@@ -218,7 +218,7 @@ bool Slider::mouseButtonEvent(const Vector2i &p, int /* button */, bool down, in
 void Slider::drawBody(SDL_Renderer* renderer)
 {
   if (!_body)
-    _body = std::make_shared<AsyncTexture>();
+    _body = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>());
 
   if (mEnabled != _lastEnabledState)
     _body->load_body(this, mEnabled);
@@ -234,7 +234,7 @@ void Slider::drawBody(SDL_Renderer* renderer)
 void Slider::drawKnob(SDL_Renderer* renderer)
 {
   if (!_knob)
-    _knob = std::make_shared<AsyncTexture>();
+    _knob = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>());
 
   if (mEnabled != _lastEnabledState)
     _knob->load_knob(this, mEnabled);
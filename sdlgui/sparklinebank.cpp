@@ -0,0 +1,218 @@
+/*
+    sdlgui/sparklinebank.cpp -- Grid of small trend lines drawn from one texture
+
+    Based on NanoGUI by Wenzel Jakob <wenzel@inf.ethz.ch>.
+    Adaptation for SDL by Dalerank <dalerankn8@gmail.com>
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <sdlgui/sparklinebank.h>
+#if defined(_WIN32)
+#include <SDL.h>
+#else
+#include <SDL.h>
+#endif
+
+NAMESPACE_BEGIN(sdlgui)
+
+namespace
+{
+    uint32_t argb(const Color& c)
+    {
+        SDL_Color sc = c.toSdlColor();
+        return ((uint32_t)sc.a << 24) | ((uint32_t)sc.r << 16) | ((uint32_t)sc.g << 8) | sc.b;
+    }
+}
+
+SparklineBank::SparklineBank(Widget *parent, int count)
+    : Widget(parent), mCellSize(90, 24)
+{
+    mBackgroundColor = Color(20, 128);
+    mForegroundColor = Color(255, 192, 0, 255);
+    setCount(count);
+}
+
+SparklineBank::~SparklineBank()
+{
+    if (mTexture)
+        SDL_DestroyTexture(mTexture);
+}
+
+int SparklineBank::count() const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    return (int)mCells.size();
+}
+
+void SparklineBank::setCount(int count)
+{
+    invalidateLayout();
+    std::lock_guard<std::mutex> guard(mMutex);
+    mCells.resize(std::max(0, count));
+    for (auto& cell : mCells)
+    {
+        cell.values.resize(mCellSize.x);
+        cell.dirty = true;
+    }
+}
+
+void SparklineBank::setCellSize(const Vector2i &size)
+{
+    invalidateLayout();
+    std::lock_guard<std::mutex> guard(mMutex);
+    mCellSize = size.cmax(Vector2i(4, 4));
+    for (auto& cell : mCells)
+    {
+        cell.values.assign(mCellSize.x, 0.f);
+        cell.head = cell.count = 0;
+        cell.dirty = true;
+    }
+}
+
+void SparklineBank::invalidate()
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    for (auto& cell : mCells)
+        cell.dirty = true;
+}
+
+void SparklineBank::push(int index, float value)
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    if (index < 0 || index >= (int)mCells.size())
+        return;
+
+    Cell& cell = mCells[index];
+    cell.values[cell.head] = value;
+    cell.head = (cell.head + 1) % cell.values.size();
+    cell.count = std::min(cell.values.size(), cell.count + 1);
+    cell.dirty = true;
+}
+
+Vector2i SparklineBank::gridSize() const
+{
+    int n = (int)mCells.size();
+    int cols = mColumns;
+    if (cols <= 0)
+        cols = std::max(1, (mSize.x + mSpacing) / (mCellSize.x + mSpacing));
+    cols = std::max(1, std::min(cols, std::max(1, n)));
+    return Vector2i(cols, (n + cols - 1) / cols);
+}
+
+int SparklineBank::indexAt(const Vector2i &p) const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    Vector2i grid = gridSize();
+    Vector2i rel = p - _pos;
+    if (rel.x < 0 || rel.y < 0)
+        return -1;
+    int col = rel.x / (mCellSize.x + mSpacing);
+    int row = rel.y / (mCellSize.y + mSpacing);
+    int index = row * grid.x + col;
+    if (col >= grid.x || index >= (int)mCells.size())
+        return -1;
+    return index;
+}
+
+Vector2i SparklineBank::preferredSize(SDL_Renderer *) const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    int n = std::max(1, (int)mCells.size());
+    int cols = mColumns > 0 ? std::min(mColumns, n) : std::min(n, 4);
+    int rows = (n + cols - 1) / cols;
+    return Vector2i(cols * (mCellSize.x + mSpacing) - mSpacing,
+                    rows * (mCellSize.y + mSpacing) - mSpacing);
+}
+
+/* 一个单元格: 背景, 按自身范围缩放的折线, 最旧的采样在左边 */
+void SparklineBank::rasterize(const Cell &cell, uint32_t *pixels, int pitch) const
+{
+    int w = mCellSize.x, h = mCellSize.y;
+    uint32_t bg = argb(mBackgroundColor);
+    uint32_t fg = argb(mForegroundColor);
+    for (int y = 0; y < h; y++)
+        std::fill(pixels + y * pitch, pixels + y * pitch + w, bg);
+    if (cell.count == 0)
+        return;
+
+    size_t cap = cell.values.size();
+    size_t first = (cell.head + cap - cell.count) % cap;
+    float lo = cell.values[first], hi = lo;
+    for (size_t i = 0; i < cell.count; i++)
+    {
+        float v = cell.values[(first + i) % cap];
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+    }
+    float scale = hi > lo ? (h - 1) / (hi - lo) : 0.f;
+
+    int x0 = w - (int)cell.count;
+    int prev = -1;
+    for (size_t i = 0; i < cell.count; i++)
+    {
+        float v = cell.values[(first + i) % cap];
+        int y = hi > lo ? (h - 1) - (int)((v - lo) * scale) : h / 2;
+        int y0 = prev < 0 ? y : std::min(prev, y);
+        int y1 = prev < 0 ? y : std::max(prev, y);
+        for (int yy = y0; yy <= y1; yy++)
+            pixels[yy * pitch + x0 + (int)i] = fg;
+        prev = y;
+    }
+}
+
+void SparklineBank::draw(SDL_Renderer *renderer)
+{
+    Widget::draw(renderer);
+
+    std::lock_guard<std::mutex> guard(mMutex);
+    if (mCells.empty())
+        return;
+
+    Vector2i grid = gridSize();
+    int stepX = mCellSize.x + mSpacing, stepY = mCellSize.y + mSpacing;
+    int texW = grid.x * stepX - mSpacing, texH = grid.y * stepY - mSpacing;
+
+    /* 网格形状或者像素尺寸 (setCellSize) 变化时重建共享纹理 */
+    if (!mTexture || grid.x != mTextureGrid.x || grid.y != mTextureGrid.y ||
+        texW != mTextureSize.x || texH != mTextureSize.y)
+    {
+        if (mTexture)
+            SDL_DestroyTexture(mTexture);
+        mTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, texW, texH);
+        if (!mTexture)
+            return;
+        SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+        mTextureGrid = grid;
+        mTextureSize = Vector2i(texW, texH);
+        mPixels.assign((size_t)texW * texH, 0);
+        for (auto& cell : mCells)
+            cell.dirty = true;
+    }
+
+    /* 重画变化的单元格, 然后把涉及的行一次上传 */
+    int rowMin = grid.y, rowMax = -1;
+    for (size_t i = 0; i < mCells.size(); i++)
+    {
+        Cell& cell = mCells[i];
+        if (!cell.dirty)
+            continue;
+        int col = (int)i % grid.x, row = (int)i / grid.x;
+        rasterize(cell, &mPixels[(size_t)row * stepY * texW + col * stepX], texW);
+        cell.dirty = false;
+        rowMin = std::min(rowMin, row);
+        rowMax = std::max(rowMax, row);
+    }
+    if (rowMax >= rowMin)
+    {
+        SDL_Rect rect{ 0, rowMin * stepY, texW, std::min(texH, (rowMax + 1) * stepY) - rowMin * stepY };
+        SDL_UpdateTexture(mTexture, &rect, &mPixels[(size_t)rect.y * texW], texW * (int)sizeof(uint32_t));
+    }
+
+    Vector2i ap = absolutePosition();
+    SDL_Rect dst{ ap.x, ap.y, texW, texH };
+    SDL_RenderCopy(renderer, mTexture, nullptr, &dst);
+}
+
+NAMESPACE_END(sdlgui)
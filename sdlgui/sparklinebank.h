@@ -0,0 +1,90 @@
+/*
+    sdlgui/sparklinebank.h -- Grid of small trend lines drawn from one texture
+
+    Based on NanoGUI by Wenzel Jakob <wenzel@inf.ethz.ch>.
+    Adaptation for SDL by Dalerank <dalerankn8@gmail.com>
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <sdlgui/widget.h>
+#include <mutex>
+
+NAMESPACE_BEGIN(sdlgui)
+
+/**
+ * \class SparklineBank sparklinebank.h sdlgui/sparklinebank.h
+ *
+ * \brief Grid of small trend lines.
+ *
+ * All the cells are rasterized into one shared texture. Each frame, only the
+ * cells that received new samples are redrawn, and the changed rows go to the
+ * texture in a single upload.
+ */
+class SparklineBank : public Widget
+{
+public:
+    SparklineBank(Widget *parent, int count = 0);
+    ~SparklineBank();
+
+    /// Number of trend lines
+    int count() const;
+    void setCount(int count);
+    SparklineBank& withCount(int count) { setCount(count); return *this; }
+
+    /// Number of columns of the grid; 0 fits as many as the width allows
+    int columns() const { return mColumns; }
+    void setColumns(int columns) { mColumns = std::max(0, columns); invalidateLayout(); }
+    SparklineBank& withColumns(int columns) { setColumns(columns); return *this; }
+
+    /// Size of one cell in pixels; each cell shows one sample per pixel column
+    const Vector2i &cellSize() const { return mCellSize; }
+    void setCellSize(const Vector2i &size);
+    SparklineBank& withCellSize(const Vector2i &size) { setCellSize(size); return *this; }
+
+    const Color &backgroundColor() const { return mBackgroundColor; }
+    void setBackgroundColor(const Color &color) { mBackgroundColor = color; invalidate(); }
+
+    const Color &foregroundColor() const { return mForegroundColor; }
+    void setForegroundColor(const Color &color) { mForegroundColor = color; invalidate(); }
+
+    /// Append a sample to trend line \p index; each line is scaled to its own range. Safe to call from any thread
+    void push(int index, float value);
+
+    /// Index of the cell under \p p (relative to the parent), or -1
+    int indexAt(const Vector2i &p) const;
+
+    Vector2i preferredSize(SDL_Renderer *ctx) const override;
+    void draw(SDL_Renderer *renderer) override;
+
+private:
+    struct Cell
+    {
+        std::vector<float> values;
+        size_t head = 0;
+        size_t count = 0;
+        bool dirty = true;
+    };
+
+    Vector2i gridSize() const;
+    void invalidate();
+    void rasterize(const Cell &cell, uint32_t *pixels, int pitch) const;
+
+    /* mCells 由 mMutex 保护, 其他线程会调用 push */
+    mutable std::mutex mMutex;
+    std::vector<Cell> mCells;
+    int mColumns = 0;
+    Vector2i mCellSize;
+    int mSpacing = 2;
+    Color mBackgroundColor, mForegroundColor;
+
+    SDL_Texture *mTexture = nullptr;
+    Vector2i mTextureGrid, mTextureSize;
+    std::vector<uint32_t> mPixels;
+};
+
+NAMESPACE_END(sdlgui)
@@ -35,7 +35,7 @@ void StackedWidget::performLayout(SDL_Renderer *ctx) {
     for (auto child : mChildren) {
       child->setPosition({ 0, 0 });
         child->setSize(mSize);
-        child->performLayout(ctx);
+        child->updateLayout(ctx);
     }
 }
 
@@ -43,7 +43,7 @@ Vector2i StackedWidget::preferredSize(SDL_Renderer *ctx) const
 {
   Vector2i size{ 0, 0 };
     for (auto child : mChildren)
-        size = size.cmax(child->preferredSize(ctx));
+        size = size.cmax(child->measure(ctx));
     return size;
 }
 
@@ -0,0 +1,172 @@
+/*
+    sdlgui/streamimageview.cpp -- Image view showing frames pushed from other threads
+
+    Based on NanoGUI by Wenzel Jakob <wenzel@inf.ethz.ch>.
+    Adaptation for SDL by Dalerank <dalerankn8@gmail.com>
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+
+#include <sdlgui/streamimageview.h>
+#if defined(_WIN32)
+#include <SDL.h>
+#else
+#include <SDL.h>
+#endif
+
+NAMESPACE_BEGIN(sdlgui)
+
+struct StreamImageView::Frame
+{
+    const void* pixels;
+    int pitch;
+    Vector2i size;
+    Uint32 format;
+    SDL_Rect dirty;
+    std::function<void()> release;
+
+    void done()
+    {
+        if (release)
+            release();
+        delete this;
+    }
+};
+
+namespace
+{
+    /* 矩形打包成 x0, y0, x1, y1 四个 16 位数, 可以用一个原子变量合并 */
+    const uint64_t emptyRect = 0x0000ffff0000ffffULL;
+
+    uint64_t packRect(const SDL_Rect& r)
+    {
+        return (uint64_t)(uint16_t)r.x | ((uint64_t)(uint16_t)r.y << 16)
+               | ((uint64_t)(uint16_t)(r.x + r.w) << 32) | ((uint64_t)(uint16_t)(r.y + r.h) << 48);
+    }
+
+    SDL_Rect unpackRect(uint64_t v)
+    {
+        int x0 = v & 0xffff, y0 = (v >> 16) & 0xffff;
+        int x1 = (v >> 32) & 0xffff, y1 = (v >> 48) & 0xffff;
+        return SDL_Rect{ x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0) };
+    }
+
+    uint64_t unionRect(uint64_t a, uint64_t b)
+    {
+        SDL_Rect ra = unpackRect(a), rb = unpackRect(b);
+        if (ra.w == 0 || ra.h == 0) return b;
+        if (rb.w == 0 || rb.h == 0) return a;
+        int x0 = std::min(ra.x, rb.x), y0 = std::min(ra.y, rb.y);
+        int x1 = std::max(ra.x + ra.w, rb.x + rb.w), y1 = std::max(ra.y + ra.h, rb.y + rb.h);
+        return packRect(SDL_Rect{ x0, y0, x1 - x0, y1 - y0 });
+    }
+}
+
+StreamImageView::StreamImageView(Widget* parent)
+    : ImageView(parent, nullptr), mMissed(emptyRect), mStreamSize(Vector2i::Zero())
+{
+}
+
+StreamImageView::~StreamImageView()
+{
+    if (Frame* frame = mPending.exchange(nullptr))
+        frame->done();
+    if (mCurrent)
+        mCurrent->done();
+    if (mStreamTexture)
+        SDL_DestroyTexture(mStreamTexture);
+}
+
+void StreamImageView::pushFrame(const void* pixels, int pitch, const Vector2i& size, Uint32 format,
+                                const SDL_Rect* dirty, const std::function<void()>& release)
+{
+    if (!pixels || size.x <= 0 || size.y <= 0 || size.x > 0xffff || size.y > 0xffff)
+    {
+        if (release)
+            release();
+        return;
+    }
+
+    SDL_Rect full{ 0, 0, size.x, size.y };
+    SDL_Rect rect = full;
+    if (dirty && !SDL_IntersectRect(dirty, &full, &rect))
+        rect = SDL_Rect{ 0, 0, 0, 0 };
+
+    Frame* frame = new Frame{ pixels, pitch, size, format, rect, release };
+    Frame* old = mPending.exchange(frame);
+    if (old)
+    {
+        /* 旧的帧没有被绘制, 它改变的区域在下一次上传时从更新的帧补上 */
+        uint64_t missed = mMissed.load();
+        uint64_t merged;
+        do
+        {
+            merged = unionRect(missed, packRect(old->dirty));
+        } while (!mMissed.compare_exchange_weak(missed, merged));
+        mFramesSkipped++;
+        old->done();
+    }
+}
+
+void StreamImageView::uploadFrame(SDL_Renderer* renderer, Frame* frame, uint64_t missed)
+{
+    /* 尺寸或格式变化时重建纹理并整幅上传 */
+    bool full = false;
+    if (!mStreamTexture || frame->size.x != mStreamSize.x || frame->size.y != mStreamSize.y
+        || frame->format != mStreamFormat)
+    {
+        if (mStreamTexture)
+            SDL_DestroyTexture(mStreamTexture);
+        mStreamTexture = SDL_CreateTexture(renderer, frame->format, SDL_TEXTUREACCESS_STREAMING,
+                                           frame->size.x, frame->size.y);
+        if (!mStreamTexture)
+        {
+            printf("Failed create stream texture %dx%d\n", frame->size.x, frame->size.y);
+            /* 旧纹理已经销毁, ImageView 不能再使用它; 下一帧按新尺寸重新创建 */
+            swapTexture(nullptr);
+            mStreamSize = Vector2i::Zero();
+            return;
+        }
+        bool resized = frame->size.x != mStreamSize.x || frame->size.y != mStreamSize.y;
+        mStreamSize = frame->size;
+        mStreamFormat = frame->format;
+        if (resized)
+            bindImage(mStreamTexture);
+        else
+            swapTexture(mStreamTexture);
+        full = true;
+    }
+
+    SDL_Rect rect = full ? SDL_Rect{ 0, 0, frame->size.x, frame->size.y }
+                         : unpackRect(unionRect(packRect(frame->dirty), missed));
+    SDL_Rect bounds{ 0, 0, frame->size.x, frame->size.y };
+    if (!SDL_IntersectRect(&rect, &bounds, &rect))
+        return;
+
+    const uint8_t* src = (const uint8_t*)frame->pixels + (size_t)rect.y * frame->pitch
+                         + (size_t)rect.x * SDL_BYTESPERPIXEL(frame->format);
+    SDL_UpdateTexture(mStreamTexture, &rect, src, frame->pitch);
+}
+
+void StreamImageView::draw(SDL_Renderer* renderer)
+{
+    Frame* frame = mPending.exchange(nullptr);
+    uint64_t missed = mMissed.exchange(emptyRect);
+    if (frame)
+    {
+        uploadFrame(renderer, frame, missed);
+        /* 保留最新的一帧, 之后补上被跳过的区域时还需要读取它 */
+        if (mCurrent)
+            mCurrent->done();
+        mCurrent = frame;
+    }
+    else if (mCurrent && missed != emptyRect)
+    {
+        uploadFrame(renderer, mCurrent, missed);
+    }
+
+    ImageView::draw(renderer);
+}
+
+NAMESPACE_END(sdlgui)
@@ -0,0 +1,64 @@
+/*
+    sdlgui/streamimageview.h -- Image view showing frames pushed from other threads
+
+    Based on NanoGUI by Wenzel Jakob <wenzel@inf.ethz.ch>.
+    Adaptation for SDL by Dalerank <dalerankn8@gmail.com>
+
+    All rights reserved. Use of this source code is governed by a
+    BSD-style license that can be found in the LICENSE.txt file.
+*/
+/** \file */
+
+#pragma once
+
+#include <sdlgui/imageview.h>
+#include <atomic>
+
+NAMESPACE_BEGIN(sdlgui)
+
+/**
+ * \class StreamImageView streamimageview.h sdlgui/streamimageview.h
+ *
+ * \brief Image view for frames produced by the application (sensors, heatmaps,
+ * spectrograms...).
+ *
+ * Frames are handed over from any thread without locks and without copying: the
+ * widget reads the caller's memory when it draws and only uploads the rectangle
+ * that changed. Zoom and pan work as in \ref ImageView.
+ */
+class StreamImageView : public ImageView
+{
+public:
+    StreamImageView(Widget* parent);
+    ~StreamImageView();
+
+    /**
+     * Hand over a frame of \p size pixels in SDL pixel \p format, with \p pitch bytes
+     * per row. Only \p dirty (all of the frame if null) is uploaded; pass the changed
+     * rows as a full-width rectangle. The memory must stay valid until \p release is
+     * called, either on the render thread once a newer frame has been uploaded, or on
+     * the thread pushing the next frame if this one was never drawn.
+     */
+    void pushFrame(const void* pixels, int pitch, const Vector2i& size, Uint32 format,
+                   const SDL_Rect* dirty = nullptr, const std::function<void()>& release = nullptr);
+
+    /// Number of frames replaced by a newer one before being drawn
+    uint64_t framesSkipped() const { return mFramesSkipped; }
+
+    void draw(SDL_Renderer* renderer) override;
+
+private:
+    struct Frame;
+    void uploadFrame(SDL_Renderer* renderer, Frame* frame, uint64_t missed);
+
+    std::atomic<Frame*> mPending{ nullptr };
+    /* 被跳过的帧的脏矩形, 打包为 4 个 16 位坐标, 在下一次上传时补上 */
+    std::atomic<uint64_t> mMissed;
+    std::atomic<uint64_t> mFramesSkipped{ 0 };
+    Frame* mCurrent = nullptr;
+    SDL_Texture* mStreamTexture = nullptr;
+    Vector2i mStreamSize;
+    Uint32 mStreamFormat = 0;
+};
+
+NAMESPACE_END(sdlgui)
@@ -193,7 +193,7 @@ void SwitchBox::drawBody(SDL_Renderer *renderer)
   }
   else
   {
-    AsyncTexturePtr newtx = std::make_shared<AsyncTexture>(id);
+    AsyncTexturePtr newtx = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>(), id);
     newtx->load_body(this, mEnabled);
     _txs.push_back(newtx);
   }
@@ -239,7 +239,7 @@ void SwitchBox::drawKnob(SDL_Renderer *renderer)
   }
   else
   {
-    AsyncTexturePtr newtx = std::make_shared<AsyncTexture>(id);
+    AsyncTexturePtr newtx = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>(), id);
     newtx->load_knob(this, mEnabled);
     _txs.push_back(newtx);
   }
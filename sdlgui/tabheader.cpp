@@ -212,6 +212,7 @@ void TabHeader::addTab(int index, const std::string &label)
 {
     assert(index <= tabCount());
     mTabButtons.insert(std::next(mTabButtons.begin(), index), TabButton(*this, label));
+    invalidateLayout();
     setActiveTab(index);
 }
 
@@ -223,6 +224,7 @@ int TabHeader::removeTab(const std::string &label)
     if (element == mTabButtons.end())
         return -1;
     mTabButtons.erase(element);
+    invalidateLayout();
     if (index == mActiveTab && index != 0)
         setActiveTab(index - 1);
     return index;
@@ -232,6 +234,7 @@ void TabHeader::removeTab(int index)
 {
     assert(index < tabCount());
     mTabButtons.erase(std::next(mTabButtons.begin(), index));
+    invalidateLayout();
     if (index == mActiveTab && index != 0)
         setActiveTab(index - 1);
 }
@@ -135,20 +135,20 @@ const std::string &TabWidget::tabLabelAt(int index) const
 
 void TabWidget::performLayout(SDL_Renderer* ctx) 
 {
-    int headerHeight = mHeader->preferredSize(ctx).y;
+    int headerHeight = mHeader->measure(ctx).y;
     int margin = mTheme->mTabInnerMargin;
     mHeader->setPosition({ 0, 0 });
     mHeader->setSize({ mSize.x, headerHeight });
-    mHeader->performLayout(ctx);
+    mHeader->updateLayout(ctx);
     mContent->setPosition({ margin, headerHeight + margin });
     mContent->setSize({ mSize.x - 2 * margin, mSize.y - 2*margin - headerHeight });
-    mContent->performLayout(ctx);
+    mContent->updateLayout(ctx);
 }
 
 Vector2i TabWidget::preferredSize(SDL_Renderer* ctx) const
 {
-    auto contentSize = mContent->preferredSize(ctx);
-    auto headerSize = mHeader->preferredSize(ctx);
+    auto contentSize = mContent->measure(ctx);
+    auto headerSize = mHeader->measure(ctx);
     int margin = mTheme->mTabInnerMargin;
     auto borderSize = Vector2i{ 2 * margin, 2 * margin };
     Vector2i tabPreferredSize = contentSize + borderSize + Vector2i{ 0, headerSize.y };
@@ -157,7 +157,7 @@ Vector2i TabWidget::preferredSize(SDL_Renderer* ctx) const
 
 void TabWidget::draw(SDL_Renderer* renderer) 
 {
-    int tabHeight = mHeader->preferredSize(nullptr).y;
+    int tabHeight = mHeader->measure(nullptr).y;
     auto activeArea = mHeader->activeButtonArea();
 
     for (int i = 0; i < 3; ++i) 
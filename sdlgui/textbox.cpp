@@ -145,29 +145,46 @@ TextBox::TextBox(Widget *parent,const std::string &value, const std::string& uni
       mMouseDragPos(Vector2i(-1,-1)),
       mMouseDownModifier(0),
       mTextOffset(0),
-      mLastClick(0) 
+      mLastClick(0),
+      mKeyboardType(type)
 {
+    mKind |= TextBoxKind;
     if (mTheme) 
       mFontSize = mTheme->mTextBoxFontSize;
 
-    Window *parentWindow = window();
-    /* parent 和 parent window 为什么是这两个呢？？？ 因为是沿用
-     * popup 控件的, 所直接用了两个，关键是这个 window() 本什么是否会用到,比如在 popup
-     * 控件中如何使用的，仔细看了下这个 mParent 主要是用来定位锚点的,即是为了定位的，
-     * 比如 keyboard 显示在哪个位置
-     * */
-    mKeyboard = new Keyboard(parentWindow->parent(), window(), type);
-    mKeyboard->setSize(Vector2i(320, 250));
-    mKeyboard->setVisible(false);
-    mKeyboard->setTextBox(this);
-
-    /* 关联这个 child widget
-     * */
-    parentWindow->addChildKeyboard(dynamic_cast<Window *>(mKeyboard));
     _captionTex.dirty = true;
     _unitsTex.dirty = true;
 }
 
+TextBox::~TextBox()
+{
+    if (mKeyboard && mKeyboard->getTextBox() == this)
+        mKeyboard->detach();
+}
+
+Keyboard *TextBox::keyboardptr()
+{
+    if (!mKeyboard && screen())
+        mKeyboard = screen()->keyboard(mKeyboardType);
+    return mKeyboard;
+}
+
+Vector2i TextBox::keyboardAnchor() const
+{
+    const Window *parentWindow = const_cast<TextBox *>(this)->window();
+    return Vector2i(parentWindow->width() + 15,
+                    absolutePosition().y - parentWindow->position().y + mSize.y / 2);
+}
+
+void TextBox::setValue(const std::string &value)
+{
+    if (mKeyboard && mKeyboard->getTextBox() == this)
+        mKeyboard->mKeyboardValue = value;
+    mValue = value;
+    _captionTex.dirty = true;
+    invalidateLayout();
+}
+
 void TextBox::setEditable(bool editable) 
 {
     mEditable = editable;
@@ -228,7 +245,7 @@ void TextBox::drawBody(SDL_Renderer* renderer)
   }
   else
   {
-    AsyncTexturePtr newtx = std::make_shared<AsyncTexture>(id);
+    AsyncTexturePtr newtx = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>(), id);
     newtx->load(this, mEditable, focused(), mValidFormat, outside);
     _txs.push_back(newtx);
   }
@@ -236,7 +253,9 @@ void TextBox::drawBody(SDL_Renderer* renderer)
 
 void TextBox::draw(SDL_Renderer* renderer) 
 {
-    mKeyboard->setVisible(!mCommitted);
+    /* 只有正在使用共享键盘的文本框控制它的显示 */
+    if (mKeyboard && mKeyboard->getTextBox() == this)
+        mKeyboard->setVisible(!mCommitted);
     Widget::draw(renderer);
 
     SDL_Point ap = getAbsolutePos();
@@ -527,6 +546,18 @@ bool TextBox::focusEvent(bool focused)
             _tempTex.dirty = true;
             mCommitted = false;
             mCursorPos = 0;
+            if (mKeyboard)
+                mKeyboard->attach(this);
+            else if (Screen *s = screen())
+            {
+                /* 第一次获得焦点时才创建键盘. 焦点事件发生在 Screen 遍历子控件的过程中,
+                 * 这时给 Screen 添加键盘会使迭代器失效, 所以推迟到下一次绘制之前 */
+                ref<TextBox> self = this;
+                s->post([self]() mutable {
+                    if (self->focused() && self->keyboardptr())
+                        self->mKeyboard->attach(self);
+                });
+            }
         } 
         else 
         {
@@ -543,6 +574,7 @@ bool TextBox::focusEvent(bool focused)
 
             mValidFormat = true;
             _captionTex.dirty = true;
+            invalidateLayout();
             mCommitted = true;
             mCursorPos = -1;
             mSelectionPos = -1;
@@ -718,7 +750,7 @@ bool TextBox::copySelection()
 {
     if (mSelectionPos > -1) 
     {
-        Screen *sc = dynamic_cast<Screen *>(this->window()->parent());
+        Screen *sc = fast_cast<Screen>(this->window()->parent());
 
         int begin = mCursorPos;
         int end = mSelectionPos;
@@ -735,7 +767,7 @@ bool TextBox::copySelection()
 
 void TextBox::pasteFromClipboard() 
 {
-    Screen *sc = dynamic_cast<Screen *>(this->window()->parent());
+    Screen *sc = fast_cast<Screen>(this->window()->parent());
     const char* cbstr = SDL_GetClipboardText();
     if (cbstr)
     {
@@ -855,11 +887,9 @@ void TextBox::performLayout(SDL_Renderer *ctx)
 {
     Widget::performLayout(ctx);
 
-    const Window *parentWindow = window();
-
     /* 设置锚点位置 */
-    mKeyboard->setAnchorPos(Vector2i(parentWindow->width() + 15,
-                         absolutePosition().y - parentWindow->position().y + mSize.y /2));
+    if (mKeyboard && mKeyboard->getTextBox() == this)
+        mKeyboard->setAnchorPos(keyboardAnchor());
 }
 NAMESPACE_END(sdlgui)
 
@@ -43,10 +43,10 @@ public:
     void setEditable(bool editable);
 
     bool spinnable() const { return mSpinnable; }
-    void setSpinnable(bool spinnable) { mSpinnable = spinnable; }
+    void setSpinnable(bool spinnable) { mSpinnable = spinnable; invalidateLayout(); }
 
     const std::string &value() const { return mValue; }
-    void setValue(const std::string &value) { mKeyboard->mKeyboardValue = value; mValue = value; _captionTex.dirty = true; }
+    void setValue(const std::string &value);
 
     const std::string &defaultValue() const { return mDefaultValue; }
     void setDefaultValue(const std::string &defaultValue) { mDefaultValue = defaultValue; }
@@ -57,10 +57,10 @@ public:
     TextBox& withAlignment(Alignment align) { setAlignment(align); return *this; }
 
     const std::string &units() const { return mUnits; }
-    void setUnits(const std::string &units) { mUnits = units; }
+    void setUnits(const std::string &units) { mUnits = units; invalidateLayout(); }
 
     int unitsImage() const { return mUnitsImage; }
-    void setUnitsImage(int image) { mUnitsImage = image; }
+    void setUnitsImage(int image) { mUnitsImage = image; invalidateLayout(); }
 
     /// Return the underlying regular expression specifying valid formats
     const std::string &format() const { return mFormat; }
@@ -84,10 +84,16 @@ public:
     Vector2i preferredSize(SDL_Renderer *ctx) const override;
     void draw(SDL_Renderer* renderer) override;
     void drawBody(SDL_Renderer* renderer);
-    Keyboard& keyboard(const Vector2i& size) { mKeyboard->setFixedSize(size); return *mKeyboard; }
-    Keyboard& keyboard() { return *mKeyboard; }
-    Keyboard* keyboardptr() { return mKeyboard; }
+    /// The on-screen keyboard of this type of text box; shared by all the text boxes of the screen.
+    /// Created when a text box of this type is first focused, or by the first call to these getters
+    Keyboard& keyboard(const Vector2i& size) { keyboardptr()->setFixedSize(size); return *keyboardptr(); }
+    Keyboard& keyboard() { return *keyboardptr(); }
+    Keyboard* keyboardptr();
+    KeyboardType keyboardType() const { return mKeyboardType; }
+    /// Anchor of the keyboard relative to the window of the text box
+    Vector2i keyboardAnchor() const;
     void performLayout(SDL_Renderer *ctx) override;
+    ~TextBox();
 protected:
     bool checkFormat(const std::string& input,const std::string& format);
     bool copySelection();
@@ -103,7 +109,9 @@ protected:
     SpinArea spinArea(const Vector2i & pos);
 
 protected:
-    Keyboard *mKeyboard = nullptr;
+    /* 屏幕共享的键盘, 第一次编辑时才获取 */
+    ref<Keyboard> mKeyboard;
+    KeyboardType mKeyboardType;
     bool mEditable;
     bool mSpinnable;
     bool mCommitted;
@@ -135,6 +143,8 @@ protected:
     std::vector<AsyncTexturePtr> _txs;
 };
 
+template<> struct WidgetKindOf<TextBox> { enum { value = Widget::TextBoxKind }; };
+
 /**
  * \class IntBox textbox.h sdl_gui/textbox.h
  *
@@ -21,6 +21,9 @@
 #include <libswscale/swscale.h>
 #include <sdlgui/widget.h>
 #include <functional>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 NAMESPACE_BEGIN(sdlgui)
 
@@ -32,6 +35,42 @@ enum VideoViewStatus
 };
 
 #define SRCURL_MAX    128
+
+/// Scaling algorithm used to convert decoded frames to the displayed size
+enum class VideoScaler
+{
+    FastBilinear = 0,
+    Bilinear,
+    Bicubic,
+};
+
+/// Decoding shortcuts taken when the UI cannot keep up with its frame budget
+enum class VideoDegrade
+{
+    None = 0,       ///< Decode every frame at full quality
+    NonRef,         ///< Skip frames that are not used as references
+    SkipLoopFilter, ///< Also skip the deblocking loop filter
+    KeyframesOnly,  ///< Decode keyframes only
+};
+
+/// Snapshot of the counters and timings of a \ref VideoView decode pipeline
+struct VideoStats
+{
+    float demuxTime = 0.f;        ///< Average time spent in av_read_frame, in ms
+    float decodeTime = 0.f;       ///< Average time spent decoding one packet, in ms
+    float scaleTime = 0.f;        ///< Average time spent converting one frame, in ms
+    float uploadTime = 0.f;       ///< Average time spent uploading one frame to the texture, in ms
+    int packetQueue = 0;          ///< Packets sent to the decoder that were neither decoded nor skipped yet
+    uint64_t framesDecoded = 0;
+    uint64_t framesPresented = 0;
+    uint64_t framesDropped = 0;   ///< Frames decoded but replaced by a newer one before presenting
+    float bitrate = 0.f;          ///< Input bitrate over the last second, in kbit/s
+    float latency = 0.f;          ///< Read-to-present latency of the last frame, in ms
+    VideoDegrade degrade = VideoDegrade::None;
+    uint64_t degradeTransitions = 0;
+    std::string lastError;
+};
+
 /**
  * \class VideoView imageview.h sdl_gui/imageview.h
  *
@@ -44,6 +83,8 @@ public:
     ~VideoView();
 
     static int video_draw_handler(void *object);
+    /* FFmpeg 阻塞调用中周期性检查, 析构时让解码线程尽快退出 */
+    static int interrupt_handler(void *object);
     void bindImage(SDL_Texture* texture);
 
     Vector2f positionF() const { return _pos.tofloat(); }
@@ -147,17 +188,164 @@ public:
     void draw(SDL_Renderer* renderer);
 
     VideoView& withImage(SDL_Texture *texture) { bindImage(texture); return *this; }
+
+    /// Return the url of the stream that is played
+    std::string source() const;
+    /// Set the url of the stream; the stream is reopened if it is already playing
+    void setSource(const std::string& url);
+
+    /// Is the low latency live profile enabled?
+    bool lowLatency() const { return mLowLatency; }
+    /**
+     * Enable the low latency live profile: no demuxer buffering, low delay decoding,
+     * small probing and only the newest decoded frame is presented. The stream is
+     * reopened if it is already playing.
+     */
+    void setLowLatency(bool lowLatency);
+    VideoView& withLowLatency(bool lowLatency) { setLowLatency(lowLatency); return *this; }
+
+    /// Return the scaling algorithm used to convert frames to the displayed size
+    VideoScaler scaler() const { return mScaler; }
+    /// Set the scaling algorithm used to convert frames to the displayed size
+    void setScaler(VideoScaler scaler) { mScaler = scaler; }
+    VideoView& withScaler(VideoScaler scaler) { setScaler(scaler); return *this; }
+
+    /// Latency between reading the packet and presenting its frame, in milliseconds
+    float lastFrameLatency() const { return mLastFrameLatency; }
+
+    /// Return a snapshot of the decode pipeline counters; safe to call from any thread
+    VideoStats stats() const;
+    /// Reset the frame counters and the last error
+    void resetStats();
+
+    /// Is the statistics overlay drawn over the video?
+    bool statsOverlay() const { return mStatsOverlay; }
+    /// Set whether the statistics overlay is drawn over the video
+    void setStatsOverlay(bool statsOverlay) { mStatsOverlay = statsOverlay; }
+    VideoView& withStatsOverlay(bool statsOverlay) { setStatsOverlay(statsOverlay); return *this; }
+
+    /// Seconds of compressed video kept in memory for \ref saveClip (0 disables the buffer)
+    double preRecord() const;
+    /**
+     * Keep the last \p seconds of compressed video packets, starting on a keyframe,
+     * so that \ref saveClip can include what happened before it was called.
+     */
+    void setPreRecord(double seconds);
+    VideoView& withPreRecord(double seconds) { setPreRecord(seconds); return *this; }
+
+    /**
+     * Save the buffered video plus the next \p postSeconds of the stream to \p path
+     * without re-encoding. The container is chosen from the extension (.mp4, .mkv).
+     * The file is written on a background thread; returns false if no stream is open.
+     */
+    bool saveClip(const std::string& path, double postSeconds);
+
+    /// Called from the writer thread with the path and the result when a clip is saved
+    void setClipCallback(const std::function<void(const std::string&, bool)>& callback);
+
+    /// Does the decoder degrade automatically when the screen misses its frame budget?
+    bool adaptiveDecode() const { return mAdaptiveDecode; }
+    /**
+     * Follow \ref Screen::frameLoad and step through the \ref VideoDegrade levels while the
+     * screen misses its frame budget, going back to full quality as headroom returns.
+     */
+    void setAdaptiveDecode(bool adaptive) { mAdaptiveDecode = adaptive; }
+    VideoView& withAdaptiveDecode(bool adaptive) { setAdaptiveDecode(adaptive); return *this; }
+
+    /// Return the current decoding degradation level
+    VideoDegrade degrade() const { return mDegrade; }
+
     SDL_Texture* mTexture = nullptr;
 
 private:
     // Helper image methods.
     void updateImageParameters();
+
+    // Helper decode methods.
+    struct ScalerCache;
+    struct Recorder;
+
+    /* 图像上的一个区域 (归一化坐标) 以及它在屏幕上的像素大小 */
+    struct Region
+    {
+        Vector2f min, max;
+        Vector2i size;
+
+        bool valid() const { return size.x > 0 && size.y > 0; }
+        bool equals(const Region& o) const
+        {
+            return min.x == o.min.x && min.y == o.min.y && max.x == o.max.x && max.y == o.max.y
+                   && size.x == o.size.x && size.y == o.size.y;
+        }
+    };
+
+    Region targetRegion() const;
+    int64_t scaleFrame(AVFrame* frame, ScalerCache& scalers, int64_t readTime);
+    void uploadFrame(SDL_Renderer* renderer);
+    void setLastError(const std::string& error);
+    void drawStatsOverlay(SDL_Renderer* renderer, const SDL_Point& ap);
+    void updateDegrade(float frameLoad);
+    static void applyDegrade(AVCodecContext* context, VideoDegrade degrade);
+
     SDL_Thread *m_thread;
     char mSrcUrl[SRCURL_MAX];
+    mutable std::mutex mSrcMutex;
     VideoViewStatus mStatus;
     uint8_t* m_pixels[4];
     int m_pitch[4];
 
+    /* 解码线程和绘制线程共享 m_pixels, mFrameSize, mFrameRegion 和 mTargetRegion, 由 mFrameMutex 保护 */
+    std::mutex mFrameMutex;
+    Vector2i mFrameSize;
+    Region mFrameRegion;
+    Region mTargetRegion;
+    Region mTextureRegion;
+    Vector2i mTextureSize;
+    bool mOwnTexture = false;
+    std::atomic<VideoScaler> mScaler{ VideoScaler::Bilinear };
+    std::atomic<uint32_t> mFrameSerial{ 0 };
+    uint32_t mPresentedSerial = 0;
+    std::atomic<int64_t> mFrameReadTime{ 0 };
+    std::atomic<float> mLastFrameLatency{ 0.f };
+
+    /* 统计数据, 写入方只有一个线程, 所以只需要原子读写 */
+    struct StatsCounters
+    {
+        std::atomic<float> demuxTime{ 0.f };
+        std::atomic<float> decodeTime{ 0.f };
+        std::atomic<float> scaleTime{ 0.f };
+        std::atomic<float> uploadTime{ 0.f };
+        std::atomic<int> packetQueue{ 0 };
+        std::atomic<uint64_t> framesDecoded{ 0 };
+        std::atomic<uint64_t> framesPresented{ 0 };
+        std::atomic<uint64_t> framesDropped{ 0 };
+        std::atomic<float> bitrate{ 0.f };
+        std::atomic<uint64_t> degradeTransitions{ 0 };
+        int64_t bitrateWindowStart = 0;
+        int64_t bitrateBytes = 0;
+        mutable std::mutex errorMutex;
+        std::string lastError;
+
+        static void average(std::atomic<float>& value, int64_t us);
+        void addDemux(int64_t us, int bytes, int64_t now);
+    };
+    StatsCounters mStats;
+    bool mStatsOverlay = false;
+    Uint32 mStatsOverlayTicks = 0;
+    Texture _statsTex[4];
+
+    std::unique_ptr<Recorder> mRecorder;
+
+    /* 绘制线程根据 Screen::frameLoad 决定等级, 解码线程在送入下一个包前应用 */
+    bool mAdaptiveDecode = true;
+    std::atomic<VideoDegrade> mDegrade{ VideoDegrade::None };
+    Uint32 mOverloadSince = 0;
+    Uint32 mHeadroomSince = 0;
+
+    std::atomic<bool> mLowLatency{ false };
+    std::atomic<bool> mReopen{ false };
+    std::atomic<bool> mQuit{ false };
+
     // Helper drawing methods.
     void drawWidgetBorder(SDL_Renderer* ctx, const SDL_Point& ap) const;
     void drawImageBorder(SDL_Renderer* ctx, const SDL_Point& ap) const;
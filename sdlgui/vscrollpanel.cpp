@@ -26,7 +26,7 @@ void VScrollPanel::performLayout(SDL_Renderer *ctx)
     if (mChildren.empty())
         return;
     Widget *child = mChildren[0];
-    mChildPreferredHeight = child->preferredSize(ctx).y;
+    mChildPreferredHeight = child->measure(ctx).y;
     child->setPosition({ 0, 0 });
     child->setSize({ mSize.x - 12, mChildPreferredHeight });
 }
@@ -35,7 +35,7 @@ Vector2i VScrollPanel::preferredSize(SDL_Renderer *ctx) const
 {
     if (mChildren.empty())
       return{ 0, 0 };
-    return mChildren[0]->preferredSize(ctx) + Vector2i(12, 0);
+    return mChildren[0]->measure(ctx) + Vector2i(12, 0);
 }
 
 bool VScrollPanel::mouseDragEvent(const Vector2i &, const Vector2i &rel,  int, int)
@@ -78,13 +78,27 @@ bool VScrollPanel::mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int
     return mChildren[0]->mouseMotionEvent(p - _pos + Vector2i{ 0, shift }, rel, button, modifiers);
 }
 
+/* 和事件分发一样加上滚动偏移, Screen 的 hover 路径才能落到正确的子控件上 */
+Widget *VScrollPanel::findWidget(const Vector2i &p)
+{
+    if (!contains(p))
+        return nullptr;
+    if (mChildren.empty() || !mChildren[0]->visible())
+        return this;
+    int shift = (int) (mScroll*(mChildPreferredHeight - mSize.y));
+    Vector2i cp = p - _pos + Vector2i{ 0, shift };
+    if (mChildren[0]->contains(cp))
+        return mChildren[0]->findWidget(cp);
+    return this;
+}
+
 void VScrollPanel::draw(SDL_Renderer *renderer) 
 {
     if (mChildren.empty())
         return;
 
     Widget *child = mChildren[0];
-    mChildPreferredHeight = child->preferredSize(nullptr).y;
+    mChildPreferredHeight = child->measure(nullptr).y;
     float scrollh = height() * std::min(1.0f, height() / (float) mChildPreferredHeight);
 
     SDL_Point ap = getAbsolutePos();
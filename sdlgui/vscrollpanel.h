@@ -33,6 +33,7 @@ public:
     bool scrollEvent(const Vector2i &p, const Vector2f &rel) override;
     bool mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers) override;
     bool mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers) override;
+    Widget *findWidget(const Vector2i &p) override;
     void draw(SDL_Renderer *render) override;
 
     SDL_Point getAbsolutePos() const override;
@@ -21,6 +21,9 @@
 
 NAMESPACE_BEGIN(sdlgui)
 
+/* 布局只在界面线程中进行, 计数不需要同步 */
+static int sMeasureCount = 0;
+
 Widget::Widget(Widget *parent)
     : mParent(nullptr), mTheme(nullptr), mLayout(nullptr),
       _pos(Vector2i::Zero()), mSize(Vector2i::Zero()),
@@ -48,6 +51,7 @@ void Widget::setTheme(Theme *theme)
     if (mTheme.get() == theme)
         return;
     mTheme = theme;
+    invalidateLayout();
     for (auto child : mChildren)
         child->setTheme(theme);
 }
@@ -67,6 +71,51 @@ Vector2i Widget::preferredSize(SDL_Renderer *ctx) const
         return mSize;
 }
 
+Vector2i Widget::measure(SDL_Renderer *ctx) const
+{
+    if (!mMeasured)
+    {
+        bool busy = mLayoutBusy;
+        mLayoutBusy = true;
+        mMeasuredSize = preferredSize(ctx);
+        mLayoutBusy = busy;
+        mMeasured = true;
+        sMeasureCount++;
+    }
+    return mMeasuredSize;
+}
+
+void Widget::updateLayout(SDL_Renderer *ctx)
+{
+    if (!mLayoutDirty)
+        return;
+    bool busy = mLayoutBusy;
+    mLayoutBusy = true;
+    performLayout(ctx);
+    mLayoutBusy = busy;
+    mLayoutDirty = false;
+}
+
+/* 向上标记到根节点; 正在 measure/performLayout 的控件对自己子树的修改已经在计算中, 到它为止 */
+void Widget::invalidateLayout()
+{
+    for (Widget *widget = this; widget && !widget->mLayoutBusy; widget = widget->mParent)
+    {
+        widget->mMeasured = false;
+        widget->mLayoutDirty = true;
+    }
+}
+
+int Widget::measureCount()
+{
+    return sMeasureCount;
+}
+
+void Widget::resetMeasureCount()
+{
+    sMeasureCount = 0;
+}
+
 void Widget::performLayout(SDL_Renderer *ctx) 
 {
   /* 如果定义了 mLayout 布局，那么直接使用这个布局初始化这个对象 */
@@ -80,7 +129,7 @@ void Widget::performLayout(SDL_Renderer *ctx)
         for (auto c : mChildren) 
         {
           /* 获取 preferredSize 和 fixedsize */
-          Vector2i pref = c->preferredSize(ctx), fix = c->fixedSize();
+          Vector2i pref = c->measure(ctx), fix = c->fixedSize();
           /* 如果有 fixedsize 那么使用 fixedsize
            * 否则使用 preferredSize
            * 这个步骤是确定大小
@@ -89,17 +138,43 @@ void Widget::performLayout(SDL_Renderer *ctx)
                 fix[0] ? fix[0] : pref[0],
                 fix[1] ? fix[1] : pref[1]
             ));
-            /* 执行 children 的 performLayout 函数 */
-            c->performLayout(ctx);
+            /* 只有尺寸变化或被标记的 children 才重新布局 */
+            c->updateLayout(ctx);
         }
     }
 }
 
+void Widget::setId(const std::string &id)
+{
+    if (mScreen && !mId.empty())
+        mScreen->unindexId(mId, this);
+    mId = id;
+    if (mScreen && !mId.empty())
+        mScreen->indexId(mId, this);
+}
+
+void Widget::setScreen(Screen *screen)
+{
+    if (mScreen == screen)
+        return;
+    if (mScreen && !mId.empty())
+        mScreen->unindexId(mId, this);
+    mScreen = screen;
+    if (mScreen && !mId.empty())
+        mScreen->indexId(mId, this);
+    for (auto child : mChildren)
+        child->setScreen(screen);
+}
+
 Widget* Widget::find(const std::string& id, bool inchildren)
 {
   if (mId == id)
     return this;
 
+  /* 已经挂到 Screen 上的控件直接查哈希索引 */
+  if (inchildren && mScreen)
+    return mScreen->findId(id, this);
+
   if (inchildren)
   {
     for (auto* child : mChildren)
@@ -113,6 +188,17 @@ Widget* Widget::find(const std::string& id, bool inchildren)
   return nullptr;
 }
 
+Widget *Widget::gfind(const std::string& id)
+{
+    if (mScreen)
+        return mScreen->findId(id);
+
+    Widget* parent = this;
+    while (parent->parent()) parent = parent->parent();
+
+    return parent->find(id, true);
+}
+
 Widget *Widget::findWidget(const Vector2i &p)
 {
     for (auto it = mChildren.rbegin(); it != mChildren.rend(); ++it) 
@@ -146,21 +232,14 @@ bool Widget::mouseButtonEvent(const Vector2i &p, int button, bool down, int modi
     return false;
 }
 
+/* 只沿着鼠标所在的路径往下传, enter/leave 事件由 Screen::updateHover 发送 */
 bool Widget::mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers)
 {
     for (auto it = mChildren.rbegin(); it != mChildren.rend(); ++it) 
     {
         Widget *child = *it;
-        /* 如果不可见就直接退出 */
-        if (!child->visible())
-            continue;
-        bool contained = child->contains(p - _pos);
-        bool prevContained = child->contains(p - _pos - rel);
-        if (contained != prevContained)
-            child->mouseEnterEvent(p, contained);
-        if ((contained || prevContained) &&
-            child->mouseMotionEvent(p - _pos, rel, button, modifiers))
-            return true;
+        if (child->visible() && child->contains(p - _pos))
+            return child->mouseMotionEvent(p - _pos, rel, button, modifiers);
     }
     return false;
 }
@@ -215,6 +294,8 @@ void Widget::addChild(int index, Widget * widget)
     widget->setParent(this);
 	/* 关联 theme */
     widget->setTheme(mTheme);
+    widget->setScreen(mScreen);
+    invalidateLayout();
 }
 
 void Widget::addChild(Widget * widget) 
@@ -230,6 +311,12 @@ void Widget::removeChild(const Widget *widget)
    * std::remove 返回的内容指向第二个 d
    * */
     mChildren.erase(std::remove(mChildren.begin(), mChildren.end(), widget), mChildren.end());
+    invalidateLayout();
+    if (mScreen == this)
+        mScreen->dropZOrder(widget);
+    if (mScreen)
+        mScreen->dropHoverPath(widget);
+    const_cast<Widget *>(widget)->setScreen(nullptr);
     widget->decRef();
 }
 
@@ -237,6 +324,12 @@ void Widget::removeChild(int index)
 {
     Widget *widget = mChildren[index];
     mChildren.erase(mChildren.begin() + index);
+    invalidateLayout();
+    if (mScreen == this)
+        mScreen->dropZOrder(widget);
+    if (mScreen)
+        mScreen->dropHoverPath(widget);
+    widget->setScreen(nullptr);
     widget->decRef();
 }
 
@@ -256,63 +349,77 @@ Window *Widget::window()
         if (!widget)
             throw std::runtime_error(
                 "Widget:internal error (could not find parent window)");
-        /* dynamic_cast 一般用来通过基类的转换为派生类的对象指针
-         * 派生类的转换为基类的转换，使用普通的指针转换就可以了
+        /* 基类指针转换为派生类指针, fast_cast 只检查 mKind 中的类型位,
+         * 不需要 dynamic_cast 的 RTTI 查找
          * */
-        Window *window = dynamic_cast<Window *>(widget);
+        Window *window = fast_cast<Window>(widget);
         if (window)
             return window;
         widget = widget->parent();
     }
 }
 
+void Widget::invalidateTransform()
+{
+    if (!mTransformValid)
+        return;
+    mTransformValid = false;
+    for (auto child : mChildren)
+        child->invalidateTransform();
+}
+
+/* 只从父节点的缓存计算, 父节点无效时先更新父节点 */
+void Widget::updateTransform() const
+{
+    if (mTransformValid)
+        return;
+
+    if (mParent)
+    {
+        mParent->updateTransform();
+        mAbsolutePos = mParent->mAbsolutePos + _pos;
+        PntRect pclip = mParent->mAbsoluteClip;
+        PntRect mclip{ mAbsolutePos.x, mAbsolutePos.y, mAbsolutePos.x + width(), mAbsolutePos.y + height() };
+        if (pclip.x1 < mclip.x1)
+          pclip.x1 = mclip.x1;
+        if (pclip.y1 < mclip.y1)
+          pclip.y1 = mclip.y1;
+        if (mclip.x2 < pclip.x2)
+          pclip.x2 = mclip.x2;
+        if (mclip.y2 < pclip.y2)
+          pclip.y2 = mclip.y2;
+        mAbsoluteClip = pclip;
+    }
+    else
+    {
+        mAbsolutePos = _pos;
+        mAbsoluteClip = PntRect{ _pos.x, _pos.y, _pos.x + width(), _pos.y + height() };
+    }
+    mTransformValid = true;
+}
+
 int Widget::getAbsoluteLeft() const
 {
-  return mParent
-    ? mParent->getAbsoluteLeft() + _pos.x
-    : _pos.x;
+  updateTransform();
+  return mAbsolutePos.x;
 }
 
 SDL_Point Widget::getAbsolutePos() const
 {
-  if (mParent)
-  {
-    SDL_Point p = mParent->getAbsolutePos();
-    return SDL_Point{ p.x + _pos.x, p.y + _pos.y };
-  }
-  else
-    return SDL_Point{ _pos.x, _pos.y };
+  updateTransform();
+  return SDL_Point{ mAbsolutePos.x, mAbsolutePos.y };
 }
 
 PntRect Widget::getAbsoluteCliprect() const
 {
-  if (mParent)
-  {
-    PntRect pclip = mParent->getAbsoluteCliprect();
-    SDL_Point pp = getAbsolutePos();
-    PntRect mclip{ pp.x, pp.y, pp.x + width(), pp.y + height() };
-    if (pclip.x1 < mclip.x1)
-      pclip.x1 = mclip.x1;
-    if (pclip.y1 < mclip.y1)
-      pclip.y1 = mclip.y1;
-    if (mclip.x2 < pclip.x2)
-      pclip.x2 = mclip.x2;
-    if (mclip.y2 < pclip.y2)
-      pclip.y2 = mclip.y2;
-
-    return pclip;
-  }
-  else
-  {
-    return PntRect{ _pos.x, _pos.y, _pos.x + width(), _pos.y + height()};
-  }
+  updateTransform();
+  return mAbsoluteClip;
 }
 
 int Widget::getAbsoluteTop() const
 {
-  return mParent
-    ? mParent->getAbsoluteTop() + _pos.y
-    : _pos.y;
+  updateTransform();
+  return mAbsolutePos.y;
 }
 
 /* 更新 focus 到当前窗口 */
@@ -329,9 +436,36 @@ void Widget::requestFocus()
 /* 绘制 mChildren 控件 */
 void Widget::draw(SDL_Renderer* renderer)
 {
+  if (mChildren.empty())
+    return;
+
+  PntRect clip = getAbsoluteCliprect();
   for (auto child : mChildren)
-    if (child->visible())
-      child->draw(renderer);
+    drawChild(renderer, child, clip);
+}
+
+/* 和当前裁剪区域不相交的子树直接跳过 */
+void Widget::drawChild(SDL_Renderer* renderer, Widget *child, const PntRect &clip)
+{
+  if (!child->visible())
+    return;
+
+  /* 还没有尺寸的控件照常绘制 */
+  if (child->width() > 0 && child->height() > 0)
+  {
+    SDL_Point cp = child->getAbsolutePos();
+    if (cp.x >= clip.x2 || cp.y >= clip.y2 ||
+        cp.x + child->width() <= clip.x1 || cp.y + child->height() <= clip.y1)
+    {
+      if (mScreen)
+        mScreen->mCulledCount++;
+      return;
+    }
+  }
+
+  if (mScreen)
+    mScreen->mDrawnCount++;
+  child->draw(renderer);
 }
 
 NAMESPACE_END(sdlgui)
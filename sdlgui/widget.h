@@ -14,6 +14,7 @@
 #include <sdlgui/theme.h>
 #include <sdlgui/layout.h>
 #include <vector>
+#include <type_traits>
 
 NAMESPACE_BEGIN(sdlgui)
 
@@ -31,6 +32,11 @@ class Slider;
 class ImagePanel;
 class DropdownBox;
 class TextBox;
+class Screen;
+
+/// Trait giving the \ref Widget::Kind bit of a widget class; 0 for the classes without one
+template<typename T> struct WidgetKindOf { enum { value = 0 }; };
+template<typename T> T *fast_cast(Widget *widget);
 /**
  * \class Widget widget.h sdl_gui/widget.h
  *
@@ -44,22 +50,43 @@ class TextBox;
 class  Widget : public Object 
 {
 public:
+    /// Kinds of widgets, set by the constructors (see \ref kind and \ref fast_cast)
+    enum Kind {
+        WindowKind   = (1 << 0),
+        PopupKind    = (1 << 1),
+        KeyboardKind = (1 << 2),
+        ScreenKind   = (1 << 3),
+        LabelKind    = (1 << 4),
+        ButtonKind   = (1 << 5),
+        TextBoxKind  = (1 << 6)
+    };
+
     /// Construct a new widget with the given parent widget
     Widget(Widget *parent);
 
+    /// Return the \ref Kind bits of this widget; a subclass has the bits of its bases
+    int kind() const { return mKind; }
+    bool isWindow() const { return (mKind & WindowKind) != 0; }
+    bool isPopup() const { return (mKind & PopupKind) != 0; }
+    bool isKeyboard() const { return (mKind & KeyboardKind) != 0; }
+    bool isScreen() const { return (mKind & ScreenKind) != 0; }
+    bool isLabel() const { return (mKind & LabelKind) != 0; }
+    bool isButton() const { return (mKind & ButtonKind) != 0; }
+    bool isTextBox() const { return (mKind & TextBoxKind) != 0; }
+
     /// Return the parent widget
     Widget *parent() { return mParent; }
     /// Return the parent widget
     const Widget *parent() const { return mParent; }
     /// Set the parent widget
-    void setParent(Widget *parent) { mParent = parent; }
+    void setParent(Widget *parent) { mParent = parent; invalidateTransform(); }
 
     /// Return the used \ref Layout generator
     Layout *layout() { return mLayout; }
     /// Return the used \ref Layout generator
     const Layout *layout() const { return mLayout.get(); }
     /// Set the used \ref Layout generator
-    void setLayout(Layout *layout) { mLayout = layout; }
+    void setLayout(Layout *layout) { mLayout = layout; invalidateLayout(); }
 
     /// Return the \ref Theme used to draw this widget
     Theme *theme() { return mTheme; }
@@ -71,31 +98,30 @@ public:
     /// Return the position relative to the parent widget
     const Vector2i &position() const { return _pos; }
     /// Set the position relative to the parent widget
-    void setPosition(const Vector2i &pos) { _pos = pos; }
-    void setPosition(int x, int y) { _pos = { x, y }; }
+    void setPosition(const Vector2i &pos) { if (_pos != pos) { _pos = pos; invalidateTransform(); } }
+    void setPosition(int x, int y) { setPosition(Vector2i(x, y)); }
 
     /// Return the absolute position on screen
     Vector2i absolutePosition() const
     {
-        return mParent 
-                  ? (mParent->absolutePosition() + _pos) 
-                  : _pos;
+        updateTransform();
+        return mAbsolutePos;
     }
 
     /// Return the size of the widget
     const Vector2i &size() const { return mSize; }
     /// set the size of the widget
-    void setSize(const Vector2i &size) { mSize = size; }
+    void setSize(const Vector2i &size) { if (mSize != size) { mSize = size; resized(); } }
 
     /// Return the width of the widget
     int width() const { return mSize.x; }
     /// Set the width of the widget
-    void setWidth(int width) { mSize.x = width; }
+    void setWidth(int width) { setSize(Vector2i(width, mSize.y)); }
 
     /// Return the height of the widget
     int height() const { return mSize.y; }
     /// Set the height of the widget
-    void setHeight(int height) { mSize.y = height; }
+    void setHeight(int height) { setSize(Vector2i(mSize.x, height)); }
 
     /**
      * \brief Set the fixed size of this widget
@@ -106,7 +132,10 @@ public:
      * size; this is done with a call to \ref setSize or a call to \ref performLayout()
      * in the parent widget.
      */
-    void setFixedSize(const Vector2i &fixedSize) { mFixedSize = fixedSize; }
+    void setFixedSize(const Vector2i &fixedSize)
+    {
+        if (mFixedSize != fixedSize) { mFixedSize = fixedSize; invalidateLayout(); }
+    }
 
     /// Return the fixed size (see \ref setFixedSize())
     const Vector2i &fixedSize() const { return mFixedSize; }
@@ -116,16 +145,23 @@ public:
     // Return the fixed height (see \ref setFixedSize())
     int fixedHeight() const { return mFixedSize.y; }
     /// Set the fixed width (see \ref setFixedSize())
-    void setFixedWidth(int width) { mFixedSize.x = width; }
+    void setFixedWidth(int width) { setFixedSize(Vector2i(width, mFixedSize.y)); }
     Widget& withFixedWidth(int width) { setFixedWidth(width); return *this; }
 
     /// Set the fixed height (see \ref setFixedSize())
-    void setFixedHeight(int height) { mFixedSize.y = height; }
+    void setFixedHeight(int height) { setFixedSize(Vector2i(mFixedSize.x, height)); }
 
     /// Return whether or not the widget is currently visible (assuming all parents are visible)
     bool visible() const { return mVisible; }
     /// Set whether or not the widget is currently visible (assuming all parents are visible)
-    void setVisible(bool visible) { mVisible = visible; }
+    void setVisible(bool visible)
+    {
+        if (mVisible == visible)
+            return;
+        mVisible = visible;
+        if (mParent)
+            mParent->invalidateLayout();
+    }
 
     /// Check if this widget is currently visible, taking parent widgets into account
     bool visibleRecursive() const {
@@ -192,8 +228,8 @@ public:
     /// Walk up the hierarchy and return the parent window
     Window *window();
 
-    /// Associate this widget with an ID value (optional)
-    void setId(const std::string &id) { mId = id; }
+    /// Associate this widget with an ID value (optional); indexed by the \ref Screen for \ref find
+    void setId(const std::string &id);
     /// Return the ID value associated with this widget, if any
     const std::string &id() const { return mId; }
 
@@ -215,7 +251,7 @@ public:
     /// Return current font size. If not set the default of the current theme will be returned
     int fontSize() const;
     /// Set the font size of this widget
-    virtual void setFontSize(int fontSize) { mFontSize = fontSize; }
+    virtual void setFontSize(int fontSize) { if (mFontSize != fontSize) { mFontSize = fontSize; invalidateLayout(); } }
     /// Return whether the font size is explicitly specified for this widget
     bool hasFontSize() const { return mFontSize > 0; }
 
@@ -232,17 +268,19 @@ public:
     }
 
     /// Determine the widget located at the given position value (recursive)
-    Widget *findWidget(const Vector2i &p);
+    virtual Widget *findWidget(const Vector2i &p);
+    /**
+     * Return the widget with ID \p id in this subtree (or this widget only). Once
+     * the widget is attached to a \ref Screen this is a hash lookup; if several
+     * widgets share the ID, any of them may be returned.
+     */
     Widget *find(const std::string& id, bool inchildren=true);
 
+    /// Return the \ref Screen this widget is attached to, if any
+    Screen *screen() const { return mScreen; }
 
-    Widget *gfind(const std::string& id)
-    {
-      Widget* parent = this;
-      while (parent->parent()) parent = parent->parent();
-
-      return parent->find(id, true);
-    }
+    /// Find a widget by ID in the whole hierarchy
+    Widget *gfind(const std::string& id);
 
     template<typename RetClass>
     RetClass *gfind(const std::string& id)
@@ -254,7 +292,11 @@ public:
     /// Handle a mouse button event (default implementation: propagate to children)
     virtual bool mouseButtonEvent(const Vector2i &p, int button, bool down, int modifiers);
 
-    /// Handle a mouse motion event (default implementation: propagate to children)
+    /**
+     * \brief Handle a mouse motion event (default implementation: propagate to the child under the cursor)
+     *
+     * Enter/leave events are not synthesized here; the \ref Screen diffs the hover path instead.
+     */
     virtual bool mouseMotionEvent(const Vector2i &p, const Vector2i &rel, int button, int modifiers);
 
     /// Handle a mouse drag event (default implementation: do nothing)
@@ -281,6 +323,29 @@ public:
     /// Invoke the associated layout generator to properly place child widgets, if any
     virtual void performLayout(SDL_Renderer *ctx);
 
+    /**
+     * \brief Return \ref preferredSize, computed again only after \ref invalidateLayout
+     * or a change of size. Layout generators measure the children with this.
+     */
+    Vector2i measure(SDL_Renderer *ctx) const;
+
+    /// Call \ref performLayout only if the widget was invalidated or resized since the last time
+    void updateLayout(SDL_Renderer *ctx);
+
+    /**
+     * \brief Mark the cached preferred size and layout of this widget and of all
+     * its parents as outdated. Widgets call it when something that affects their
+     * preferred size changes (text, font, children, visibility, fixed size).
+     */
+    void invalidateLayout();
+
+    /// Is the layout of this widget outdated?
+    bool layoutDirty() const { return mLayoutDirty; }
+
+    /// Number of \ref preferredSize calls made by \ref measure since the last \ref resetMeasureCount
+    static int measureCount();
+    static void resetMeasureCount();
+
     /// Draw the widget (and all child widgets)
     virtual void draw(SDL_Renderer* renderer);
 
@@ -302,7 +367,7 @@ public:
     template<typename LayoutClass,typename... Args>
     Widget& withLayout(const Args&... args) { setLayout(new LayoutClass(args...)); return *this; }
 
-    template<typename RetClass> RetClass* cast() { return dynamic_cast<RetClass*>(this); }
+    template<typename RetClass> RetClass* cast() { return fast_cast<RetClass>(this); }
 
     template<typename... Args>Widget& boxlayout(const Args&... args) { return withLayout<BoxLayout>(args...); }
     template<typename... Args>ToolButton& toolbutton(const Args&... args) { return wdg<ToolButton>(args...); }
@@ -326,6 +391,25 @@ protected:
     /// Free all resources used by the widget and any children
     virtual ~Widget();
 
+    /// Drop the cached preferred size of this widget only, after its size changed
+    void resized() { mMeasured = false; mLayoutDirty = true; invalidateTransform(); }
+
+    /**
+     * Mark the cached absolute position and clip rectangle of this subtree as
+     * outdated. An outdated widget always has outdated children, so this stops
+     * at the first widget that is already outdated.
+     */
+    void invalidateTransform();
+
+    /// Recompute the absolute position and clip rectangle from the parent, if outdated
+    void updateTransform() const;
+
+    /// Draw \p child unless it is hidden or lies outside \p clip; used by \ref draw
+    void drawChild(SDL_Renderer* renderer, Widget *child, const PntRect &clip);
+
+    /// Attach this subtree to \p screen (or detach it), updating the ID index
+    void setScreen(Screen *screen);
+
 protected:
     Widget *mParent;
     ref<Theme> mTheme;
@@ -339,6 +423,42 @@ protected:
     std::string mTooltip;
     int mFontSize;
     Cursor mCursor;
+    int mKind = 0;
+
+    /* preferredSize 的缓存, 以及布局是否需要重新计算 */
+    mutable Vector2i mMeasuredSize;
+    mutable bool mMeasured = false;
+    bool mLayoutDirty = true;
+    /* 正在 measure 或 performLayout 的控件不会被自己子树中的修改重新标记 */
+    mutable bool mLayoutBusy = false;
+
+    /* 所在的 Screen, 由 addChild/removeChild 维护 */
+    Screen *mScreen = nullptr;
+
+    /* 绝对位置和裁剪区域的缓存, 位置/尺寸/父节点变化时失效 */
+    mutable Vector2i mAbsolutePos;
+    mutable PntRect mAbsoluteClip;
+    mutable bool mTransformValid = false;
 };
 
+/**
+ * \brief Cast \p widget to \c T, or return nullptr if it is not one.
+ *
+ * For the classes with a \ref Widget::Kind bit this is a bit test instead of
+ * a dynamic_cast; the other classes fall back to dynamic_cast.
+ */
+template<typename T> T *fast_cast(Widget *widget)
+{
+    /* fast_cast<const Window> 也要用 Window 的类型位 */
+    typedef WidgetKindOf<typename std::remove_cv<T>::type> Kind;
+    if (Kind::value != 0)
+        return widget && (widget->kind() & Kind::value) ? static_cast<T *>(widget) : nullptr;
+    return dynamic_cast<T *>(widget);
+}
+
+template<typename T> const T *fast_cast(const Widget *widget)
+{
+    return fast_cast<T>(const_cast<Widget *>(widget));
+}
+
 NAMESPACE_END(sdlgui)
@@ -12,6 +12,8 @@
 #include <sdlgui/theme.h>
 #include <sdlgui/screen.h>
 #include <sdlgui/layout.h>
+#include <sdlgui/textbox.h>
+#include <sdlgui/popup.h>
 #if defined(_WIN32)
 #include <SDL.h>
 #else
@@ -150,6 +152,7 @@ struct Window::AsyncTexture
 Window::Window(Widget *parent, const std::string &title)
     : Widget(parent), mTitle(title), mButtonPanel(nullptr), mModal(false), mDrag(false)
 {
+  mKind |= WindowKind;
   _titleTex.dirty = true;
 }
 
@@ -194,8 +197,8 @@ void Window::performLayout(SDL_Renderer *ctx)
         }
         mButtonPanel->setVisible(true);
         mButtonPanel->setSize({ width(), 22 });
-        mButtonPanel->setPosition({ width() - (mButtonPanel->preferredSize(ctx).x + 5), 3 });
-        mButtonPanel->performLayout(ctx);
+        mButtonPanel->setPosition({ width() - (mButtonPanel->measure(ctx).x + 5), 3 });
+        mButtonPanel->updateLayout(ctx);
     }
 }
 
@@ -266,7 +269,7 @@ void Window::drawBody(SDL_Renderer* renderer)
   }
   else
   {
-    AsyncTexturePtr newtx = std::make_shared<AsyncTexture>(id);
+    AsyncTexturePtr newtx = std::allocate_shared<AsyncTexture>(PoolAllocator<AsyncTexture>(), id);
     newtx->load(this, 0, 0, mMouseFocus);
     _txs.push_back(newtx);
 
@@ -319,9 +322,9 @@ bool Window::mouseDragEvent(const Vector2i &, const Vector2i &rel,
     }
     if (mDrag && (button & (1 << SDL_BUTTON_LEFT)) != 0)
     {
-        _pos += rel;
-        _pos = _pos.cmax({ 0, 0 });
-        _pos = _pos.cmin(parent()->size() - mSize);
+        Vector2i pos = _pos + rel;
+        pos = pos.cmax({ 0, 0 });
+        setPosition(pos.cmin(parent()->size() - mSize));
         return true;
     }
     return false;
@@ -361,13 +364,32 @@ bool Window::childKeyboardTouched(const Vector2i &p) const
 
 Window::~Window()
 {
+    /* 键盘由 Screen 共享, 这里只解除关联 */
     for (auto child : mChildKeyboard) 
     {
-        if (child)
-        {
-          /* 析构 children keyboard window */
-            child->dispose();
-        }
+        Keyboard *keyboard = fast_cast<Keyboard>(child);
+        if (keyboard && keyboard->parentWindow() == this)
+            keyboard->detach();
     }
+    /* popup 可能比父窗口活得久, 断开它们和这个窗口的关联 */
+    for (auto popup : mPopups)
+        popup->mParentWindow = nullptr;
+}
+
+void Window::attachPopup(Popup *popup)
+{
+    mPopups.push_back(popup);
+}
+
+void Window::detachPopup(Popup *popup)
+{
+    mPopups.erase(std::remove(mPopups.begin(), mPopups.end(), popup), mPopups.end());
+}
+
+void Window::raisePopup(Popup *popup)
+{
+    auto it = std::find(mPopups.begin(), mPopups.end(), popup);
+    if (it != mPopups.end())
+        std::rotate(it, it + 1, mPopups.end());
 }
 NAMESPACE_END(sdlgui)
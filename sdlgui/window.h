@@ -17,6 +17,8 @@
 
 NAMESPACE_BEGIN(sdlgui)
 
+class Popup;
+
 /**
  * \class Window window.h sdl_gui/window.h
  *
@@ -26,6 +28,7 @@ class  Window : public Widget
 {
     friend class Popup;
     friend class Keyboard;
+    friend class Screen;
 public:
     Window(Widget *parent, const std::string &title = "Untitled");
     Window(Widget *parent, const std::string &title, const Vector2i& pos)
@@ -34,7 +37,7 @@ public:
     /// Return the window title
     const std::string &title() const { return mTitle; }
     /// Set the window title
-    void setTitle(const std::string &title) { mTitle = title; }
+    void setTitle(const std::string &title) { mTitle = title; invalidateLayout(); }
 
     /// Is this a model dialog?
     bool modal() const { return mModal; }
@@ -84,16 +87,28 @@ public:
     void addChildKeyboard(Window *keyboard) {
         mChildKeyboard.push_back(keyboard);
     };
+    void removeChildKeyboard(Window *keyboard) {
+        mChildKeyboard.erase(std::remove(mChildKeyboard.begin(), mChildKeyboard.end(), keyboard), mChildKeyboard.end());
+    }
+
+    /// Return the popups attached to this window, bottom to top; they are raised together with it
+    const std::vector<Popup *> &popups() const { return mPopups; }
 
 protected:
     /// Internal helper function to maintain nested window position values; overridden in \ref Popup
     void refreshRelativePlacement();
     virtual ~Window();
+    /* 由 Popup 构造/析构时维护 */
+    void attachPopup(Popup *popup);
+    void detachPopup(Popup *popup);
+    /* 把 popup 移到本层 popup 的最上面 */
+    void raisePopup(Popup *popup);
 protected:
 
     std::string mTitle;
     Widget *mButtonPanel;
     std::vector<Window *> mChildKeyboard; /* 指向 Keyboard child 控件指针 */
+    std::vector<Popup *> mPopups; /* 挂在这个窗口上的 popup, 按 z-order 从下到上 */
 
     Texture _titleTex;
 
@@ -107,4 +122,6 @@ protected:
     std::vector<AsyncTexturePtr> _txs;
 };
 
+template<> struct WidgetKindOf<Window> { enum { value = Widget::WindowKind }; };
+
 NAMESPACE_END(sdlgui)